@@ -0,0 +1,99 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Marco Calignano
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compressor.h"
+
+#include <QFile>
+#include <QRunnable>
+#include <QTextStream>
+#include <utility>
+#include <zlib.h>
+
+namespace {
+
+class CompressTask : public QRunnable {
+public:
+    CompressTask(const QString &fileName, std::function<void(bool)> done,
+                 QSemaphore &slots) :
+        m_fileName(fileName),
+        m_done(std::move(done)),
+        m_slots(slots) {
+    }
+    void run() override {
+        auto ok = Compressor::gzipFile(m_fileName);
+        // Free the queue slot before calling done.
+        m_slots.release();
+        if (!ok) {
+            QTextStream(stdout) << "Could not compress " << m_fileName << endl;
+        }
+        if (m_done) {
+            m_done(ok);
+        }
+    }
+private:
+    QString m_fileName;
+    std::function<void(bool)> m_done;
+    QSemaphore &m_slots;
+};
+
+}
+
+Compressor::Compressor(int threads, int maxQueued) :
+    m_slots(maxQueued) {
+    m_pool.setMaxThreadCount(threads);
+}
+
+Compressor::~Compressor() {
+    waitForDone();
+}
+
+void Compressor::compress(const QString &fileName,
+                          std::function<void(bool)> done) {
+    m_slots.acquire();
+    m_pool.start(new CompressTask(fileName, std::move(done), m_slots));
+}
+
+void Compressor::waitForDone() {
+    m_pool.waitForDone();
+}
+
+bool Compressor::gzipFile(const QString &fileName) {
+    QFile in(fileName);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    auto gzName = fileName + ".gz";
+    auto out = gzopen(QFile::encodeName(gzName).constData(), "wb");
+    if (!out) {
+        return false;
+    }
+    auto ok = true;
+    while (ok && !in.atEnd()) {
+        auto data = in.read(64 * 1024);
+        ok = !data.isEmpty()
+            && gzwrite(out, data.constData(), data.size()) == data.size();
+    }
+    ok = (gzclose(out) == Z_OK) && ok;
+    in.close();
+    if (!ok) {
+        QFile::remove(gzName);
+        return false;
+    }
+    // gzip removes the original.
+    return in.remove();
+}
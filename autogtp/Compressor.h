@@ -0,0 +1,49 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Marco Calignano
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+
+/*
+    Gzips files with zlib on a few background threads, so the thread
+    handling game results doesn't wait for it. At most maxQueued files
+    wait for compression, compress() blocks when the queue is full.
+*/
+class Compressor {
+public:
+    Compressor(int threads, int maxQueued);
+    ~Compressor();
+
+    // Replace fileName by fileName.gz, like gzip does, then call done
+    // on the compressing thread with whether that worked.
+    void compress(const QString &fileName, std::function<void(bool)> done);
+    void waitForDone();
+
+    static bool gzipFile(const QString &fileName);
+
+private:
+    QThreadPool m_pool;
+    QSemaphore m_slots;
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include <QTextStream>
 #include <QRegularExpression>
 #include <QFileInfo>
+#include <QElapsedTimer>
 #include "Game.h"
 
 Game::Game(const QString& weights, const QString& opt, const QString& binary,
@@ -32,8 +33,10 @@ Game::Game(const QString& weights, const QString& opt, const QString& binary,
     m_resignation(false),
     m_blackToMove(true),
     m_blackResigned(false),
+    m_adjudicated(false),
     m_passes(0),
-    m_moveNum(0)
+    m_moveNum(0),
+    m_startupTime(0)
 {
 #ifdef WIN32
     m_binary.append(".exe");
@@ -47,6 +50,7 @@ Game::Game(const QString& weights, const QString& opt, const QString& binary,
 
 bool Game::checkGameEnd() {
     return (m_resignation ||
+            m_adjudicated ||
             m_passes > 1 ||
             m_moveNum > (19 * 19 * 2));
 }
@@ -113,6 +117,31 @@ bool Game::sendGtpCommand(QString cmd) {
     return true;
 }
 
+bool Game::sendGtpQuery(QString cmd, QString& answer) {
+    write(qPrintable(cmd.append("\n")));
+    waitForBytesWritten(-1);
+    if (!waitReady()) {
+        error(Game::PROCESS_DIED);
+        return false;
+    }
+    char readBuffer[256];
+    int readCount = readLine(readBuffer, 256);
+    if (readCount <= 0 || readBuffer[0] != '=') {
+        QTextStream(stdout) << "GTP: " << readBuffer << endl;
+        error(Game::WRONG_GTP);
+        return false;
+    }
+    // Skip "= "
+    answer = readBuffer;
+    answer.remove(0, 2);
+    answer = answer.simplified();
+    if (!eatNewLine()) {
+        error(Game::PROCESS_DIED);
+        return false;
+    }
+    return true;
+}
+
 void Game::checkVersion(const VersionTuple &min_version) {
     write(qPrintable("version\n"));
     waitForBytesWritten(-1);
@@ -171,6 +200,8 @@ void Game::checkVersion(const VersionTuple &min_version) {
 }
 
 bool Game::gameStart(const VersionTuple &min_version) {
+    QElapsedTimer timer;
+    timer.start();
     start(m_cmdLine);
     if (!waitForStarted()) {
         error(Game::NO_LEELAZ);
@@ -189,6 +220,33 @@ bool Game::gameStart(const VersionTuple &min_version) {
         }
     }
     QTextStream(stdout) << "Thinking time set." << endl;
+    m_startupTime = timer.elapsed();
+    return true;
+}
+
+bool Game::gameReset() {
+    // Reuse the running engine for a new game instead of paying
+    // for another process start, network load and tuning.
+    m_winner.clear();
+    m_result.clear();
+    m_moveDone.clear();
+    m_resignation = false;
+    m_blackToMove = true;
+    m_blackResigned = false;
+    m_adjudicated = false;
+    m_passes = 0;
+    m_moveNum = 0;
+    m_fileName = QUuid::createUuid().toRfc4122().toHex();
+    if (!sendGtpCommand(QStringLiteral("clear_board"))
+        || !sendGtpCommand(QStringLiteral("komi 7.5"))) {
+        return false;
+    }
+    for (auto command : m_commands) {
+        if (!sendGtpCommand(command)) {
+            QTextStream(stdout) << "GTP failed on: " << command << endl;
+            return false;
+        }
+    }
     return true;
 }
 
@@ -326,6 +384,33 @@ bool Game::getScore() {
     return true;
 }
 
+bool Game::getWinrate(float& blackWinrate) {
+    QString answer;
+    if (!sendGtpQuery(QStringLiteral("lz-winrate b"), answer)) {
+        return false;
+    }
+    bool ok;
+    blackWinrate = answer.toFloat(&ok);
+    return ok;
+}
+
+bool Game::getAreaScore(float& blackScore) {
+    QString answer;
+    if (!sendGtpQuery(QStringLiteral("final_score"), answer)) {
+        return false;
+    }
+    // "B+3.5", "W+3.5" or "0"
+    auto ok = true;
+    if (answer.startsWith('B', Qt::CaseInsensitive)) {
+        blackScore = answer.mid(2).toFloat(&ok);
+    } else if (answer.startsWith('W', Qt::CaseInsensitive)) {
+        blackScore = -answer.mid(2).toFloat(&ok);
+    } else {
+        blackScore = 0.0f;
+    }
+    return ok;
+}
+
 int Game::getWinner() {
     if (m_winner.compare(QStringLiteral("white"), Qt::CaseInsensitive) == 0)
         return Game::WHITE;
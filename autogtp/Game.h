@@ -32,11 +32,20 @@ public:
          const QStringList& commands = QStringList("time_settings 0 1 0"));
     ~Game() = default;
     bool gameStart(const VersionTuple& min_version);
+    bool gameReset();
+    bool isRunning() const { return state() == QProcess::Running; }
+    qint64 getStartupTime() const { return m_startupTime; }
     void move();
     bool waitForMove() { return waitReady(); }
     bool readMove();
     bool nextMove();
     bool getScore();
+    // Root winrate for black of the last search of this engine.
+    bool getWinrate(float& blackWinrate);
+    // Area score for black of the current position.
+    bool getAreaScore(float& blackScore);
+    void setAdjudicated() { m_adjudicated = true; }
+    bool isAdjudicated() const { return m_adjudicated; }
     bool loadSgf(const QString &fileName);
     bool writeSgf();
     bool loadTraining(const QString &fileName);
@@ -78,9 +87,12 @@ private:
     bool m_resignation;
     bool m_blackToMove;
     bool m_blackResigned;
+    bool m_adjudicated;
     int m_passes;
     int m_moveNum;
+    qint64 m_startupTime;
     bool sendGtpCommand(QString cmd);
+    bool sendGtpQuery(QString cmd, QString& answer);
     void checkVersion(const VersionTuple &min_version);
     bool waitReady();
     bool eatNewLine();
@@ -55,6 +55,10 @@ Job(gpu, parent)
 {
 }
 
+ProductionJob::~ProductionJob() {
+    quitEngine();
+}
+
 ValidationJob::ValidationJob(QString gpu, Management *parent) :
 Job(gpu, parent)
 {
@@ -65,12 +69,39 @@ Job(gpu, parent)
 {
 }
 
+bool ProductionJob::prepareEngine() {
+    if (m_game && m_game->isRunning()
+        && m_gameNetwork == m_network && m_gameOption == m_option) {
+        if (m_game->gameReset()) {
+            return true;
+        }
+        QTextStream(stdout) << "Engine reset failed, restarting." << endl;
+    }
+    quitEngine();
+    m_game = std::make_unique<Game>("networks/" + m_network + ".gz",
+                                    m_option);
+    m_gameNetwork = m_network;
+    m_gameOption = m_option;
+    if (!m_game->gameStart(m_leelazMinVersion)) {
+        m_game.reset();
+        return false;
+    }
+    return true;
+}
+
+void ProductionJob::quitEngine() {
+    if (m_game) {
+        m_game->gameQuit();
+        m_game.reset();
+    }
+}
+
 Result ProductionJob::execute(){
     Result res(Result::Error);
-    Game game("networks/" + m_network + ".gz", m_option);
-    if (!game.gameStart(m_leelazMinVersion)) {
+    if (!prepareEngine()) {
         return res;
     }
+    auto& game = *m_game;
     if (!m_sgf.isEmpty()) {
         game.loadSgf(m_sgf);
         game.loadTraining(m_sgf);
@@ -81,6 +112,7 @@ Result ProductionJob::execute(){
     do {
         game.move();
         if (!game.waitForMove()) {
+            quitEngine();
             return res;
         }
         game.readMove();
@@ -112,7 +144,9 @@ Result ProductionJob::execute(){
     default:
         break;
     }
-    game.gameQuit();
+    if (m_state.load() != RUNNING) {
+        quitEngine();
+    }
     return res;
 }
 
@@ -24,6 +24,8 @@
 #include <QObject>
 #include <QAtomicInt>
 #include <QTextStream>
+#include <memory>
+class Game;
 class Management;
 using VersionTuple = std::tuple<int, int, int>;
 
@@ -62,13 +64,20 @@ class ProductionJob : public Job {
     Q_OBJECT
 public:
     ProductionJob(QString gpu, Management *parent);
-    ~ProductionJob() = default;
+    ~ProductionJob();
     void init(const Order &o);
     Result execute();
 private:
     QString m_network;
     QString m_sgf;
     bool m_debug;
+    // The engine is kept running between games and only restarted
+    // when the network or the options change.
+    std::unique_ptr<Game> m_game;
+    QString m_gameNetwork;
+    QString m_gameOption;
+    bool prepareEngine();
+    void quitEngine();
 };
 
 class ValidationJob : public Job {
@@ -27,6 +27,9 @@
 #include <QLockFile>
 #include <QUuid>
 #include <QRegularExpression>
+#include <QRunnable>
+#include <functional>
+#include <utility>
 #include "Management.h"
 #include "Game.h"
 
@@ -34,8 +37,24 @@
 constexpr int RETRY_DELAY_MIN_SEC = 30;
 constexpr int RETRY_DELAY_MAX_SEC = 60 * 60;  // 1 hour
 constexpr int MAX_RETRIES = 3;           // Stop retrying after 3 times
+constexpr int COMPRESS_THREADS = 2;
+constexpr int MAX_COMPRESS_QUEUE = 16;
 const QString Leelaz_min_version = "0.12";
 
+namespace {
+class UploadTask : public QRunnable {
+public:
+    explicit UploadTask(std::function<void()> upload) :
+        m_upload(std::move(upload)) {
+    }
+    void run() override {
+        m_upload();
+    }
+private:
+    std::function<void()> m_upload;
+};
+}
+
 Management::Management(const int gpus,
                        const int games,
                        const QStringList& gpuslist,
@@ -61,7 +80,9 @@ Management::Management(const int gpus,
     m_gamesLeft(maxGames),
     m_threadsLeft(gpus * games),
     m_delNetworks(delNetworks),
-    m_lockFile(nullptr) {
+    m_lockFile(nullptr),
+    m_compressor(COMPRESS_THREADS, MAX_COMPRESS_QUEUE) {
+    m_uploader.setMaxThreadCount(1);
 }
 
 void Management::runTuningProcess(const QString &tuneCmdLine) {
@@ -147,6 +168,9 @@ void Management::storeGames() {
         m_gamesThreads[i]->doStore();
     }
     wait();
+    QTextStream(stdout) << "Management: waiting for uploads" << endl;
+    m_compressor.waitForDone();
+    m_uploader.waitForDone();
 }
 
 void Management::wait() {
@@ -582,13 +606,47 @@ void Management::cleanupFiles(const QString &fileName) {
     }
 }
 
-void Management::gzipFile(const QString &fileName) {
-    QString gzipCmd ="gzip";
-#ifdef WIN32
-    gzipCmd.append(".exe");
-#endif
-    gzipCmd.append(" " + fileName);
-    QProcess::execute(gzipCmd);
+void Management::sendWithRetries(const QStringList &prog_cmdline, const QString &fileName) {
+    bool sent = false;
+    for (auto retries = 0; retries < MAX_RETRIES; retries++) {
+        try {
+            sent = sendCurl(prog_cmdline);
+            break;
+        } catch (NetworkException ex) {
+            QTextStream(stdout)
+                << "Network connection to server failed." << endl;
+            QTextStream(stdout)
+                << ex.what() << endl;
+            auto retry_delay =
+                std::min<int>(
+                    RETRY_DELAY_MIN_SEC * std::pow(1.5, retries),
+                    RETRY_DELAY_MAX_SEC);
+            QTextStream(stdout) << "Retrying in " << retry_delay << " s."
+                                << endl;
+            QThread::sleep(retry_delay);
+        }
+    }
+    if (!sent) {
+        saveCurlCmdLine(prog_cmdline, fileName);
+        return;
+    }
+    cleanupFiles(fileName);
+}
+
+void Management::compressAndUpload(const QStringList &prog_cmdline, const QString &fileName) {
+    // The uploads and their retries run on their own thread, so a slow
+    // server doesn't hold up the compression queue.
+    m_compressor.compress(fileName + ".sgf",
+                          [this, prog_cmdline, fileName](bool compressed) {
+        if (!compressed) {
+            // sendAllGames compresses and sends it later.
+            saveCurlCmdLine(prog_cmdline, fileName);
+            return;
+        }
+        m_uploader.start(new UploadTask([this, prog_cmdline, fileName]() {
+            sendWithRetries(prog_cmdline, fileName);
+        }));
+    });
 }
 
 void Management::saveCurlCmdLine(const QStringList &prog_cmdline, const QString &name) {
@@ -640,6 +698,11 @@ void Management::sendAllGames() {
             lines << tmp;
         }
         file.close();
+        // Saved because its SGF couldn't be compressed, try again.
+        if (QFileInfo::exists(name + ".sgf")
+            && !Compressor::gzipFile(name + ".sgf")) {
+            continue;
+        }
         bool sent = false;
 
         try {
@@ -706,7 +769,6 @@ void Management::uploadResult(const QMap<QString,QString> &r, const QMap<QString
     QTextStream(stdout) << "Uploading match: " << r["file"] << ".sgf for networks ";
     QTextStream(stdout) << l["firstNet"] << " and " << l["secondNet"] << endl;
     archiveFiles(r["file"]);
-    gzipFile(r["file"] + ".sgf");
     QStringList prog_cmdline;
     if (r["winner"] == "black") {
         prog_cmdline.append("-F winnerhash=" + l["firstNet"]);
@@ -724,30 +786,7 @@ void Management::uploadResult(const QMap<QString,QString> &r, const QMap<QString
     prog_cmdline.append("-F sgf=@"+ r["file"] + ".sgf.gz");
     prog_cmdline.append("http://localhost/submit-match");
 
-    bool sent = false;
-    for (auto retries = 0; retries < MAX_RETRIES; retries++) {
-        try {
-            sent = sendCurl(prog_cmdline);
-            break;
-        } catch (NetworkException ex) {
-            QTextStream(stdout)
-                << "Network connection to server failed." << endl;
-            QTextStream(stdout)
-                << ex.what() << endl;
-            auto retry_delay =
-                std::min<int>(
-                    RETRY_DELAY_MIN_SEC * std::pow(1.5, retries),
-                    RETRY_DELAY_MAX_SEC);
-            QTextStream(stdout) << "Retrying in " << retry_delay << " s."
-                                << endl;
-            QThread::sleep(retry_delay);
-        }
-    }
-    if (!sent) {
-        saveCurlCmdLine(prog_cmdline, r["file"]);
-        return;
-    }
-    cleanupFiles(r["file"]);
+    compressAndUpload(prog_cmdline, r["file"]);
 }
 
 
@@ -764,7 +803,6 @@ http://zero.sjeng.org/submit
 void Management::uploadData(const QMap<QString,QString> &r, const QMap<QString,QString> &l) {
     QTextStream(stdout) << "Uploading game: " << r["file"] << ".sgf for network " << l["network"] << endl;
     archiveFiles(r["file"]);
-    gzipFile(r["file"] + ".sgf");
     QStringList prog_cmdline;
     prog_cmdline.append("-F networkhash=" + l["network"]);
     prog_cmdline.append("-F clientversion=" + QString::number(m_version));
@@ -776,30 +814,7 @@ void Management::uploadData(const QMap<QString,QString> &r, const QMap<QString,Q
     prog_cmdline.append("-F trainingdata=@" + r["file"] + ".txt.0.gz");
     prog_cmdline.append("http://localhost/submit");
 
-    bool sent = false;
-    for (auto retries = 0; retries < MAX_RETRIES; retries++) {
-        try {
-            sent = sendCurl(prog_cmdline);
-            break;
-        } catch (NetworkException ex) {
-            QTextStream(stdout)
-                << "Network connection to server failed." << endl;
-            QTextStream(stdout)
-                << ex.what() << endl;
-            auto retry_delay =
-                std::min<int>(
-                    RETRY_DELAY_MIN_SEC * std::pow(1.5, retries),
-                    RETRY_DELAY_MAX_SEC);
-            QTextStream(stdout) << "Retrying in " << retry_delay << " s."
-                                << endl;
-            QThread::sleep(retry_delay);
-        }
-    }
-    if (!sent) {
-        saveCurlCmdLine(prog_cmdline, r["file"]);
-        return;
-    }
-    cleanupFiles(r["file"]);
+    compressAndUpload(prog_cmdline, r["file"]);
 }
 
 void Management::checkStoredGames() {
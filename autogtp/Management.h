@@ -23,11 +23,13 @@
 #include <QString>
 #include <QTextStream>
 #include <QThread>
+#include <QThreadPool>
 #include <QFileInfo>
 #include <QLockFile>
 #include <QVector>
 #include <chrono>
 #include <stdexcept>
+#include "Compressor.h"
 #include "Worker.h"
 
 constexpr int AUTOGTP_VERSION = 17;
@@ -83,6 +85,10 @@ private:
     bool m_delNetworks;
     QLockFile *m_lockFile;
     QString m_leelaversion;
+    // Uploads the compressed game files one at a time. Declared before
+    // the compressor, whose tasks hand their files to it.
+    QThreadPool m_uploader;
+    Compressor m_compressor;
 
     Order getWorkInternal(bool tuning);
     Order getWork(bool tuning = false);
@@ -97,7 +103,8 @@ private:
     void fetchNetwork(const QString &net, const QString &hash);
     void printTimingInfo(float duration);
     void runTuningProcess(const QString &tuneCmdLine);
-    void gzipFile(const QString &fileName);
+    void sendWithRetries(const QStringList &prog_cmdline, const QString &fileName);
+    void compressAndUpload(const QStringList &prog_cmdline, const QString &fileName);
     bool sendCurl(const QStringList &lines);
     void saveCurlCmdLine(const QStringList &prog_cmdline, const QString &name);
     void archiveFiles(const QString &fileName);
@@ -23,7 +23,8 @@ SOURCES += main.cpp \
     Worker.cpp \
     Order.cpp \
     Job.cpp \
-    Management.cpp
+    Management.cpp \
+    Compressor.cpp
 
 HEADERS += \
     Game.h \
@@ -32,4 +33,7 @@ HEADERS += \
     Order.h \
     Result.h \
     Management.h \
-    Console.h
+    Console.h \
+    Compressor.h
+
+LIBS += -lz
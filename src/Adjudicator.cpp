@@ -0,0 +1,73 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include "Adjudicator.h"
+
+Adjudicator::Adjudicator(int winrate_pct, int moves, int min_moves,
+                         int playout_pct)
+    : m_winrate(winrate_pct / 100.0f), m_moves(moves),
+      m_min_moves(min_moves), m_playout_pct(playout_pct),
+      m_rng(std::random_device{}()) {
+}
+
+void Adjudicator::new_game() {
+    m_movenum = 0;
+    m_streak = 0;
+    m_leader = NONE;
+    m_playout_game =
+        std::uniform_int_distribution<int>{0, 99}(m_rng) < m_playout_pct;
+}
+
+Adjudicator::Winner Adjudicator::add_move(float black_winrate,
+                                          float black_score) {
+    m_movenum++;
+    if (m_winrate <= 0.0f || m_playout_game) {
+        return NONE;
+    }
+
+    auto by_winrate = NONE;
+    if (black_winrate >= m_winrate) {
+        by_winrate = BLACK;
+    } else if (1.0f - black_winrate >= m_winrate) {
+        by_winrate = WHITE;
+    }
+    auto by_score = NONE;
+    if (black_score > 0.1f) {
+        by_score = BLACK;
+    } else if (black_score < -0.1f) {
+        by_score = WHITE;
+    }
+
+    if (by_winrate == NONE || by_winrate != by_score) {
+        m_streak = 0;
+        m_leader = NONE;
+        return NONE;
+    }
+    if (by_winrate != m_leader) {
+        m_streak = 0;
+        m_leader = by_winrate;
+    }
+    m_streak++;
+
+    if (m_movenum >= m_min_moves && m_streak >= m_moves) {
+        return m_leader;
+    }
+    return NONE;
+}
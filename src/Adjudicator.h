@@ -0,0 +1,71 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ADJUDICATOR_H_INCLUDED
+#define ADJUDICATOR_H_INCLUDED
+
+#include <random>
+
+/*
+    Ends games early once they are decided. A game is adjudicated
+    when, for a number of consecutive moves, the root winrate of the
+    engine that moved and the area score both favor the same player.
+    The engines alternate, so both have to agree. A fraction of the
+    games is always played out to keep the resignation and
+    adjudication statistics honest.
+
+    Only uses the standard library so validation can share it.
+*/
+class Adjudicator {
+public:
+    // Same values as FastBoard and autogtp's Game.
+    enum Winner {
+        NONE = -1,
+        BLACK = 0,
+        WHITE = 1
+    };
+
+    // winrate_pct: adjudicate at this winrate, 0 disables.
+    // moves: number of consecutive moves that must agree.
+    // min_moves: never adjudicate before this move.
+    // playout_pct: percentage of games that are played out.
+    Adjudicator(int winrate_pct, int moves, int min_moves, int playout_pct);
+
+    // Start a new game. Randomly decides if it is played out.
+    void new_game();
+    bool is_playout_game() const { return m_playout_game; }
+
+    // Add the position after a move. black_winrate is the root winrate
+    // for black of the engine that moved and black_score the area
+    // score for black. Returns the adjudicated winner or NONE.
+    Winner add_move(float black_winrate, float black_score);
+
+private:
+    float m_winrate;
+    int m_moves;
+    int m_min_moves;
+    int m_playout_pct;
+
+    bool m_playout_game{false};
+    int m_movenum{0};
+    int m_streak{0};
+    Winner m_leader{NONE};
+    std::minstd_rand m_rng;
+};
+
+#endif
@@ -0,0 +1,166 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "AnalysisEmitter.h"
+#include "UCTSearch.h"
+#include "Utils.h"
+
+using namespace Utils;
+
+AnalysisEmitter::~AnalysisEmitter() {
+    stop();
+}
+
+void AnalysisEmitter::start(const FastState& state, UCTNode& root,
+                            int interval_centis, int max_cpu_pct) {
+    stop();
+    m_state = std::make_unique<FastState>(state);
+    m_root = &root;
+    m_interval = std::chrono::milliseconds(10 * interval_centis);
+    m_max_cpu_pct = std::min(100, std::max(1, max_cpu_pct));
+    m_emitted.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = true;
+    m_thread = std::thread(&AnalysisEmitter::worker, this);
+}
+
+void AnalysisEmitter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+    }
+    m_condvar.notify_all();
+    m_thread.join();
+}
+
+void AnalysisEmitter::worker() {
+    using namespace std::chrono;
+    auto delay = m_interval;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        if (m_condvar.wait_for(lock, delay, [this]{ return !m_running; })) {
+            return;
+        }
+        lock.unlock();
+        const auto start = steady_clock::now();
+        emit();
+        const auto spent =
+            duration_cast<milliseconds>(steady_clock::now() - start);
+        lock.lock();
+
+        // Spending `spent` must be at most max_cpu_pct of the time
+        // until the next line.
+        delay = std::max(m_interval,
+                         spent * (100 - m_max_cpu_pct) / m_max_cpu_pct);
+    }
+}
+
+void AnalysisEmitter::emit() {
+    struct Snapshot {
+        UCTNode* node;
+        int move;
+        int visits;
+        float winrate;
+        float prior;
+    };
+
+    if (!m_root->has_children()) {
+        return;
+    }
+    const auto color = m_state->get_to_move();
+
+    // Copy the statistics first, the search keeps changing them.
+    auto snapshot = std::vector<Snapshot>{};
+    for (const auto& child : m_root->get_children()) {
+        const auto visits = child.get_visits();
+        if (!visits) {
+            continue;
+        }
+        snapshot.push_back({child.get(), child.get_move(), visits,
+                            child->get_raw_eval(color), child.get_policy()});
+    }
+    if (snapshot.empty()) {
+        return;
+    }
+    std::stable_sort(begin(snapshot), end(snapshot),
+        [](const Snapshot& a, const Snapshot& b) {
+            if (a.visits == b.visits) {
+                return a.winrate > b.winrate;
+            }
+            return a.visits > b.visits;
+        });
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4);
+    auto changed = 0;
+    for (auto order = 0; order < static_cast<int>(snapshot.size()); order++) {
+        const auto& child = snapshot[order];
+        auto& emitted = m_emitted[child.move];
+        if (emitted.visits == child.visits && emitted.order == order) {
+            continue;
+        }
+        const auto move = m_state->move_to_text(child.move);
+        out << (changed++ ? "," : "")
+            << "{\"move\":\"" << move << "\""
+            << ",\"order\":" << order
+            << ",\"visits\":" << child.visits
+            << ",\"winrate\":" << child.winrate
+            << ",\"prior\":" << child.prior;
+
+        // The PV can only have changed if the subtree got new visits.
+        if (emitted.visits != child.visits) {
+            auto state = *m_state;
+            state.play_move(child.move);
+            const auto pv = UCTSearch::get_pv(state, *child.node);
+            if (!emitted.has_pv || pv != emitted.pv) {
+                out << ",\"pv\":[\"" << move << "\"";
+                std::istringstream moves(pv);
+                for (std::string pv_move; moves >> pv_move; ) {
+                    out << ",\"" << pv_move << "\"";
+                }
+                out << "]";
+                emitted.has_pv = true;
+                emitted.pv = pv;
+            }
+        }
+        out << "}";
+        emitted.visits = child.visits;
+        emitted.order = order;
+    }
+    if (!changed) {
+        return;
+    }
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(4)
+         << "{\"visits\":" << m_root->get_visits()
+         << ",\"winrate\":" << m_root->get_raw_eval(color)
+         << ",\"moves\":[" << out.str() << "]}\n";
+    gtp_printf_raw("%s", line.str().c_str());
+}
@@ -0,0 +1,77 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYSISEMITTER_H_INCLUDED
+#define ANALYSISEMITTER_H_INCLUDED
+
+#include "config.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "FastState.h"
+#include "UCTNode.h"
+
+/*
+    Writes search analysis as JSON lines from its own thread, so the
+    search threads never spend time formatting it. Each line holds the
+    root visits and winrate and only the root moves whose visits or
+    order changed since the previous line. Principal variations are
+    only included when they changed. The time spent building output
+    is kept under a percentage of the wall time by waiting longer
+    than the interval when needed.
+*/
+class AnalysisEmitter {
+public:
+    ~AnalysisEmitter();
+
+    // state must be the position of root. Both must stay alive
+    // until stop() returns.
+    void start(const FastState& state, UCTNode& root,
+               int interval_centis, int max_cpu_pct);
+    void stop();
+
+private:
+    struct Emitted {
+        int visits{-1};
+        int order{-1};
+        bool has_pv{false};
+        std::string pv;
+    };
+
+    void worker();
+    void emit();
+
+    std::unique_ptr<FastState> m_state;
+    UCTNode* m_root{nullptr};
+    std::chrono::milliseconds m_interval{0};
+    int m_max_cpu_pct{0};
+    std::unordered_map<int, Emitted> m_emitted;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condvar;
+    bool m_running{false};
+    std::thread m_thread;
+};
+
+#endif
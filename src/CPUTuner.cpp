@@ -0,0 +1,255 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef USE_MKL
+#include <mkl.h>
+#endif
+#ifdef USE_OPENBLAS
+#include <cblas.h>
+#endif
+
+#include "CPUTuner.h"
+#include "GTP.h"
+#include "Network.h"
+#include "Utils.h"
+
+using namespace Utils;
+
+const auto CPU_TUNER_FILE_LOCAL = std::string("leelaz_cpu_tuning");
+
+// More threads make the search itself less efficient, so a bigger
+// setting must be at least this much faster to be preferred.
+constexpr auto MIN_SPEEDUP = 1.05f;
+
+std::string CPUTuner::get_cpu_model() {
+    auto model = std::string{};
+    auto file = std::ifstream{"/proc/cpuinfo"};
+    if (file.good()) {
+        auto line = std::string{};
+        while (std::getline(file, line)) {
+            if (line.find("model name") == 0) {
+                auto pos = line.find(':');
+                if (pos != std::string::npos) {
+                    model = line.substr(pos + 1);
+                    model.erase(0, model.find_first_not_of(" \t"));
+                }
+                break;
+            }
+        }
+    }
+    if (model.empty()) {
+        model = "unknown CPU";
+    }
+    // ';' is our field separator.
+    for (auto& c : model) {
+        if (c == ';') {
+            c = ',';
+        }
+    }
+    return model;
+}
+
+std::string CPUTuner::get_backend() {
+#ifdef USE_BLAS
+#if defined(__APPLE__)
+    return "accelerate";
+#elif defined(USE_OPENBLAS)
+    return std::string("openblas-") + openblas_get_corename();
+#elif defined(USE_MKL)
+    return "mkl";
+#else
+    return "blas";
+#endif
+#else
+    return "eigen";
+#endif
+}
+
+bool CPUTuner::supports_intra_op_threads() {
+#if defined(USE_BLAS) && !defined(__APPLE__) \
+    && (defined(USE_OPENBLAS) || defined(USE_MKL))
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CPUTuner::set_intra_op_threads(const int threads) {
+#if defined(USE_BLAS) && !defined(__APPLE__)
+#ifdef USE_OPENBLAS
+    openblas_set_num_threads(threads);
+#endif
+#ifdef USE_MKL
+    mkl_set_num_threads(threads);
+#endif
+#endif
+    (void)threads;
+}
+
+float CPUTuner::measure(const Setting& setting, const int centiseconds) {
+    cfg_num_threads = setting.first;
+    set_intra_op_threads(setting.second);
+    return m_network.benchmark_time(centiseconds);
+}
+
+CPUTuner::Setting CPUTuner::tune(const int max_threads) {
+    auto candidates = std::vector<Setting>{};
+    auto intra_max = supports_intra_op_threads() ? max_threads : 1;
+    for (auto threads = 1; threads <= max_threads; threads *= 2) {
+        for (auto intra = 1; intra == 1 || threads * intra <= intra_max;
+             intra *= 2) {
+            candidates.emplace_back(threads, intra);
+        }
+    }
+    if (candidates.back().first != max_threads) {
+        candidates.emplace_back(max_threads, 1);
+    }
+
+    myprintf("Started CPU tuning (%d thread(s) max).\n", max_threads);
+    myprintf("Batch size is fixed at %d.\n", MAX_BATCH);
+
+    auto best = candidates.front();
+    auto best_score = 0.0f;
+    for (const auto& setting : candidates) {
+        const auto score = measure(setting, 100);
+        myprintf("%2d search thread(s), %2d BLAS thread(s): %8.1f n/s\n",
+                 setting.first, setting.second, score);
+        if (score > best_score * MIN_SPEEDUP) {
+            best = setting;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+std::string CPUTuner::tuning_line_prefix(const int max_threads) const {
+    auto prefix = std::stringstream{};
+    prefix << TUNER_VERSION << ";" << get_backend() << ";"
+           << m_network.get_channels() << ";"
+           << m_network.get_residual_blocks() << ";"
+           << MAX_BATCH << ";" << max_threads << ";";
+    return prefix.str();
+}
+
+bool CPUTuner::setting_from_line(const std::string& line,
+                                 const int max_threads,
+                                 Setting& setting) const {
+    auto s = std::vector<std::string>{};
+    auto ss = std::stringstream{line};
+    auto item = std::string{};
+
+    while (std::getline(ss, item, ';')) {
+        s.emplace_back(item);
+    }
+
+    if (s.size() != 9) {
+        return false;
+    }
+
+    if (line.find(tuning_line_prefix(max_threads)) != 0) {
+        return false;
+    }
+
+    if (s[8] != get_cpu_model()) {
+        return false;
+    }
+
+    // A damaged line is skipped, so we retune instead of failing.
+    try {
+        setting.first = std::stoi(s[6]);
+        setting.second = std::stoi(s[7]);
+    } catch (const std::logic_error&) {
+        return false;
+    }
+    return setting.first >= 1 && setting.first <= max_threads
+        && setting.second >= 1;
+}
+
+void CPUTuner::store(const int max_threads, const Setting& setting) {
+    auto tuner_file = leelaz_file(CPU_TUNER_FILE_LOCAL);
+    auto file_contents = std::vector<std::string>();
+    {
+        // Read the previous contents to string
+        auto file = std::ifstream{tuner_file};
+        if (file.good()) {
+            auto line = std::string{};
+            while (std::getline(file, line)) {
+                file_contents.emplace_back(line);
+            }
+        }
+    }
+    auto file = std::ofstream{tuner_file};
+
+    auto cpu_model = get_cpu_model();
+    auto prefix = tuning_line_prefix(max_threads);
+    auto tuning_line = prefix + std::to_string(setting.first) + ";"
+        + std::to_string(setting.second) + ";" + cpu_model;
+
+    // Write back previous data as long as it's not the CPU and
+    // network shape we just tuned
+    for (const auto& line : file_contents) {
+        if (line.find(prefix) != 0
+            || line.find(cpu_model) == std::string::npos) {
+            file << line << std::endl;
+        }
+    }
+
+    // Write new tuning
+    file << tuning_line << std::endl;
+
+    if (file.fail()) {
+        myprintf("Could not save the CPU tuning result.\n");
+        myprintf("Do I have write permissions on %s?\n",
+            tuner_file.c_str());
+    }
+}
+
+void CPUTuner::load_or_tune() {
+    const auto max_threads = cfg_num_threads;
+    auto setting = Setting{};
+    auto loaded = false;
+
+    auto file = std::ifstream{leelaz_file(CPU_TUNER_FILE_LOCAL)};
+    if (file.good()) {
+        auto line = std::string{};
+        while (std::getline(file, line)) {
+            if (setting_from_line(line, max_threads, setting)) {
+                myprintf("Loaded existing CPU tuning.\n");
+                loaded = true;
+                break;
+            }
+        }
+    }
+    if (!loaded) {
+        setting = tune(max_threads);
+        store(max_threads, setting);
+    }
+
+    cfg_num_threads = setting.first;
+    set_intra_op_threads(setting.second);
+    myprintf("CPU tuning: %d search thread(s), %d BLAS thread(s) (%s).\n",
+             setting.first, setting.second, get_backend().c_str());
+}
@@ -0,0 +1,65 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CPUTUNER_H_INCLUDED
+#define CPUTUNER_H_INCLUDED
+
+#include "config.h"
+
+#include <string>
+#include <utility>
+
+class Network;
+
+/*
+    Startup tuning for CPU-only evaluation. Benchmarks combinations of
+    search threads and BLAS threads on a loaded network and remembers
+    the fastest one per CPU model and network shape, the same way Tuner
+    remembers SGEMM parameters per OpenCL device.
+*/
+class CPUTuner {
+public:
+    static constexpr auto TUNER_VERSION = 0;
+
+    explicit CPUTuner(Network & network) : m_network(network) {}
+
+    // Sets cfg_num_threads (and the BLAS thread count, if the BLAS
+    // library supports it) from the tuning file, tuning first if
+    // there is no matching entry. The current cfg_num_threads is the
+    // upper bound on the total number of threads used.
+    void load_or_tune();
+
+    static std::string get_cpu_model();
+    static std::string get_backend();
+private:
+    using Setting = std::pair<int, int>;
+
+    Setting tune(const int max_threads);
+    float measure(const Setting& setting, const int centiseconds);
+    std::string tuning_line_prefix(const int max_threads) const;
+    bool setting_from_line(const std::string& line, const int max_threads,
+                           Setting& setting) const;
+    void store(const int max_threads, const Setting& setting);
+
+    static bool supports_intra_op_threads();
+    static void set_intra_op_threads(const int threads);
+
+    Network & m_network;
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <cstdio>
+#include <thread>
+#include <tuple>
+
+#include <boost/format.hpp>
+
+#include "Calibration.h"
+#include "GTP.h"
+#include "Timing.h"
+
+Calibration::Calibration(Network* network, Network* anchor_network,
+                         const std::vector<float>& levels,
+                         const std::vector<float>& anchors)
+    : m_network(network), m_anchor_network(anchor_network),
+      m_levels(levels), m_anchors(anchors) {
+}
+
+Match* Calibration::next_match() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Match* best = nullptr;
+    for (const auto& match : m_matches) {
+        if (match->finished() || match->games_started() >= m_max_games) {
+            continue;
+        }
+        if (!best || match->games_started() < best->games_started()) {
+            best = match.get();
+        }
+    }
+    return best;
+}
+
+void Calibration::run(int concurrency, int max_games_per_pairing,
+                      double elo_margin) {
+    m_max_games = max_games_per_pairing;
+    m_matches.clear();
+    for (const auto level : m_levels) {
+        for (const auto anchor : m_anchors) {
+            auto player = Match::Player{
+                boost::str(boost::format("level %.2f") % level),
+                m_network, {}};
+            player.strength.c_param = level;
+            auto opponent = Match::Player{
+                boost::str(boost::format("anchor %.2f") % anchor),
+                m_anchor_network, {}};
+            opponent.strength.c_param = anchor;
+            m_matches.emplace_back(std::make_unique<Match>(
+                player, opponent, m_max_games));
+            m_matches.back()->set_elo_margin(elo_margin);
+        }
+    }
+
+    printf("Calibrating %zu level(s) against %zu anchor(s), "
+           "%d games at a time.\n",
+           m_levels.size(), m_anchors.size(), concurrency);
+
+    // See Match::run.
+    const auto search_threads = cfg_num_threads;
+    cfg_num_threads = 1;
+
+    const Time start;
+    auto games = std::vector<std::thread>{};
+    for (auto i = 0; i < concurrency; i++) {
+        games.emplace_back([this]() {
+            while (auto match = next_match()) {
+                match->play_next_game();
+            }
+        });
+    }
+    for (auto& game : games) {
+        game.join();
+    }
+    const Time end;
+
+    cfg_num_threads = search_threads;
+    printf("Calibration finished in %.1f seconds.\n",
+           Time::timediff_seconds(start, end));
+}
+
+bool Calibration::write_table(const std::string& filename) const {
+    auto file = fopen(filename.c_str(), "w");
+    if (!file) {
+        printf("Could not open %s for writing.\n", filename.c_str());
+        return false;
+    }
+
+    const auto header = std::string{
+        "# level  anchor  games  wins  draws  losses     elo  +-95%\n"};
+    printf("%s", header.c_str());
+    fprintf(file, "%s", header.c_str());
+    for (const auto& match : m_matches) {
+        int wins, draws, losses;
+        std::tie(wins, draws, losses) = match->get_sprt().get_wdl();
+        // Do not count the draw the SPRT starts with.
+        draws--;
+        const auto elo = match->get_sprt().get_elo();
+        const auto line = boost::str(
+            boost::format("%7.2f %7.2f %6d %5d %6d %7d %7.1f %6.1f\n")
+            % match->get_player(0).strength.c_param
+            % match->get_player(1).strength.c_param
+            % (wins + draws + losses) % wins % draws % losses
+            % elo.diff % elo.error);
+        printf("%s", line.c_str());
+        fprintf(file, "%s", line.c_str());
+    }
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,63 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CALIBRATION_H_INCLUDED
+#define CALIBRATION_H_INCLUDED
+
+#include "config.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Match.h"
+#include "Network.h"
+
+/*
+    Calibrates the strength control levels of a network. Every level
+    plays a gauntlet against a set of fixed anchors. All pairings are
+    played at the same time, so the games of every level share the
+    network evaluation cache, and each pairing stops as soon as its
+    Elo difference is known within the requested margin.
+*/
+class Calibration {
+public:
+    Calibration(Network* network, Network* anchor_network,
+                const std::vector<float>& levels,
+                const std::vector<float>& anchors);
+
+    void run(int concurrency, int max_games_per_pairing, double elo_margin);
+    // Writes one line per pairing: level, anchor, games and Elo.
+    bool write_table(const std::string& filename) const;
+
+private:
+    // The undecided pairing with the fewest games, or nullptr.
+    Match* next_match();
+
+    Network* m_network;
+    Network* m_anchor_network;
+    std::vector<float> m_levels;
+    std::vector<float> m_anchors;
+    int m_max_games{0};
+    // m_levels.size() x m_anchors.size() pairings.
+    std::vector<std::unique_ptr<Match>> m_matches;
+    std::mutex m_mutex;
+};
+
+#endif
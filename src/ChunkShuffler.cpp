@@ -0,0 +1,323 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChunkShuffler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "FastBoard.h"
+#include "Random.h"
+#include "Utils.h"
+#include "Zobrist.h"
+#include "zlib.h"
+
+namespace {
+
+// The lines of one position: the stone planes, the side to move,
+// the probabilities and the winner.
+constexpr auto SAMPLE_LINES = ChunkSample::STONE_PLANES + 3;
+
+using SymmetryTable =
+    std::array<std::array<int, NUM_INTERSECTIONS>, Network::NUM_SYMMETRIES>;
+
+const SymmetryTable& symmetry_table() {
+    static const auto table = [] {
+        auto table = SymmetryTable{};
+        for (auto s = 0; s < Network::NUM_SYMMETRIES; s++) {
+            for (auto v = 0; v < NUM_INTERSECTIONS; v++) {
+                const auto newvtx = Network::get_symmetry(
+                    {v % BOARD_SIZE, v / BOARD_SIZE}, s);
+                table[s][v] = (newvtx.second * BOARD_SIZE) + newvtx.first;
+            }
+        }
+        return table;
+    }();
+    return table;
+}
+
+std::string read_file(const std::string& filename) {
+    // gzread passes uncompressed files through unchanged.
+    auto in = gzopen(filename.c_str(), "rb");
+    if (!in) {
+        throw std::runtime_error("Could not open " + filename);
+    }
+    auto data = std::string{};
+    char buffer[64 * 1024];
+    int bytes;
+    while ((bytes = gzread(in, buffer, sizeof(buffer))) > 0) {
+        data.append(buffer, bytes);
+    }
+    gzclose(in);
+    if (bytes < 0) {
+        throw std::runtime_error("Error reading " + filename);
+    }
+    return data;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// The inverse of the plane encoding in Training::dump_training.
+bool parse_plane(const std::string& line, TimeStep::BoardPlane& plane) {
+    const auto hex_chars = size_t{NUM_INTERSECTIONS / 4};
+    if (line.size() != hex_chars + 1) {
+        return false;
+    }
+    for (auto i = size_t{0}; i < hex_chars; i++) {
+        const auto value = hex_value(line[i]);
+        if (value < 0) {
+            return false;
+        }
+        plane[4 * i]     = value & 8;
+        plane[4 * i + 1] = value & 4;
+        plane[4 * i + 2] = value & 2;
+        plane[4 * i + 3] = value & 1;
+    }
+    const auto last = line.back();
+    if (last != '0' && last != '1') {
+        return false;
+    }
+    plane[NUM_INTERSECTIONS - 1] = (last == '1');
+    return true;
+}
+
+bool parse_sample(const std::vector<std::string>& lines, size_t first,
+                  ChunkSample& sample) {
+    for (auto p = 0; p < ChunkSample::STONE_PLANES; p++) {
+        if (!parse_plane(lines[first + p], sample.planes[p])) {
+            return false;
+        }
+    }
+
+    const auto& to_move = lines[first + ChunkSample::STONE_PLANES];
+    if (to_move != "0" && to_move != "1") {
+        return false;
+    }
+    sample.to_move = (to_move == "0") ? FastBoard::BLACK : FastBoard::WHITE;
+
+    auto text = lines[first + ChunkSample::STONE_PLANES + 1].c_str();
+    for (auto& prob : sample.probabilities) {
+        char* end;
+        prob = std::strtof(text, &end);
+        // Old versions could write NaN probabilities.
+        if (end == text || std::isnan(prob)) {
+            return false;
+        }
+        text = end;
+    }
+
+    const auto& winner = lines[first + ChunkSample::STONE_PLANES + 2];
+    if (winner != "1" && winner != "-1") {
+        return false;
+    }
+    sample.winner = (winner == "1") ? 1.0f : -1.0f;
+    return true;
+}
+
+}
+
+ChunkSample ChunkSample::apply_symmetry(int symmetry) const {
+    const auto& table = symmetry_table()[symmetry];
+    auto result = *this;
+    for (auto p = 0; p < STONE_PLANES; p++) {
+        for (auto v = 0; v < NUM_INTERSECTIONS; v++) {
+            result.planes[p][v] = planes[p][table[v]];
+        }
+    }
+    // Pass stays where it is.
+    for (auto v = 0; v < NUM_INTERSECTIONS; v++) {
+        result.probabilities[v] = probabilities[table[v]];
+    }
+    return result;
+}
+
+std::uint64_t ChunkSample::get_symmetry_hash(int symmetry) const {
+    const auto& table = symmetry_table()[symmetry];
+    // Plane 0 has the stones of the side to move, plane INPUT_MOVES
+    // those of the opponent.
+    const auto& own = planes[0];
+    const auto& opponent = planes[Network::INPUT_MOVES];
+    auto hash = std::uint64_t{Zobrist::zobrist_empty};
+    for (auto v = 0; v < NUM_INTERSECTIONS; v++) {
+        if (own[table[v]]) {
+            hash ^= Zobrist::zobrist[0][v];
+        } else if (opponent[table[v]]) {
+            hash ^= Zobrist::zobrist[1][v];
+        }
+    }
+    if (to_move == FastBoard::BLACK) {
+        hash ^= Zobrist::zobrist_blacktomove;
+    }
+    return hash;
+}
+
+ChunkShuffler::ChunkShuffler(const std::string& prefix,
+                             size_t shuffle_size, size_t shard_size)
+    : m_prefix(prefix),
+      m_shuffle_size(std::max(shuffle_size, size_t{1})),
+      m_shard_size(std::max(shard_size, size_t{1})) {
+    m_winners.reserve(m_shard_size);
+    m_weights.reserve(m_shard_size);
+    m_probabilities.reserve(m_shard_size * POTENTIAL_MOVES);
+    m_planes.reserve(m_shard_size * Network::INPUT_CHANNELS
+                     * NUM_INTERSECTIONS);
+}
+
+std::vector<ChunkSample> ChunkShuffler::load_chunk(
+    const std::string& filename) {
+
+    const auto data = read_file(filename);
+    auto lines = std::vector<std::string>{};
+    auto start = size_t{0};
+    while (start < data.size()) {
+        auto end = data.find('\n', start);
+        if (end == std::string::npos) {
+            end = data.size();
+        }
+        lines.emplace_back(data, start, end - start);
+        start = end + 1;
+    }
+
+    auto samples = std::vector<ChunkSample>{};
+    auto skipped = 0;
+    auto sample = ChunkSample{};
+    for (auto first = size_t{0}; first + SAMPLE_LINES <= lines.size();
+         first += SAMPLE_LINES) {
+        if (parse_sample(lines, first, sample)) {
+            samples.emplace_back(sample);
+        } else {
+            skipped++;
+        }
+    }
+    if (skipped) {
+        Utils::myprintf("%s: skipped %d malformed positions\n",
+                        filename.c_str(), skipped);
+    }
+    return samples;
+}
+
+std::vector<ChunkSample> ChunkShuffler::augment(
+    const std::vector<ChunkSample>& samples, bool all_symmetries) {
+
+    auto result = std::vector<ChunkSample>{};
+    result.reserve(samples.size()
+                   * (all_symmetries ? Network::NUM_SYMMETRIES : 1));
+    for (const auto& sample : samples) {
+        if (all_symmetries) {
+            for (auto s = 0; s < Network::NUM_SYMMETRIES; s++) {
+                result.emplace_back(sample.apply_symmetry(s));
+            }
+        } else {
+            const auto s = Random::get_Rng().randfix<Network::NUM_SYMMETRIES>();
+            result.emplace_back(sample.apply_symmetry(s));
+        }
+    }
+    return result;
+}
+
+void ChunkShuffler::add(const std::vector<ChunkSample>& samples) {
+    for (const auto& sample : samples) {
+        insert(sample);
+    }
+}
+
+void ChunkShuffler::insert(const ChunkSample& sample) {
+    if (m_reservoir.size() < m_shuffle_size) {
+        m_reservoir.emplace_back(sample);
+        // Keep the reservoir shuffled (Fisher-Yates).
+        const auto i = Random::get_Rng().randuint64(m_reservoir.size());
+        std::swap(m_reservoir[i], m_reservoir.back());
+        return;
+    }
+    const auto i = Random::get_Rng().randuint64(m_reservoir.size());
+    write(m_reservoir[i]);
+    m_reservoir[i] = sample;
+}
+
+void ChunkShuffler::finish() {
+    // The reservoir is kept shuffled, so it can be written in order.
+    for (const auto& sample : m_reservoir) {
+        write(sample);
+    }
+    m_reservoir.clear();
+    flush_shard();
+}
+
+void ChunkShuffler::write(const ChunkSample& sample) {
+    m_winners.emplace_back(sample.winner);
+    m_weights.emplace_back(sample.weight);
+    m_probabilities.insert(end(m_probabilities),
+                           begin(sample.probabilities),
+                           end(sample.probabilities));
+    for (const auto& plane : sample.planes) {
+        for (auto v = 0; v < NUM_INTERSECTIONS; v++) {
+            m_planes.emplace_back(plane[v]);
+        }
+    }
+    // Side to move planes, as in Network::gather_features.
+    const auto black_to_move = (sample.to_move == FastBoard::BLACK);
+    m_planes.insert(end(m_planes), NUM_INTERSECTIONS, black_to_move);
+    m_planes.insert(end(m_planes), NUM_INTERSECTIONS, !black_to_move);
+
+    if (m_winners.size() >= m_shard_size) {
+        flush_shard();
+    }
+}
+
+void ChunkShuffler::flush_shard() {
+    if (m_winners.empty()) {
+        return;
+    }
+    const auto name = m_prefix + "." + std::to_string(m_shard_count)
+                      + ".shard";
+    auto out = std::ofstream{name, std::ofstream::binary};
+
+    auto header = ShardHeader{{'L', 'Z', 'S', 'H'}, SHARD_VERSION,
+                              BOARD_SIZE, Network::INPUT_CHANNELS,
+                              static_cast<std::uint32_t>(m_winners.size())};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(m_winners.data()),
+              m_winners.size() * sizeof(float));
+    out.write(reinterpret_cast<const char*>(m_weights.data()),
+              m_weights.size() * sizeof(float));
+    out.write(reinterpret_cast<const char*>(m_probabilities.data()),
+              m_probabilities.size() * sizeof(float));
+    out.write(reinterpret_cast<const char*>(m_planes.data()),
+              m_planes.size());
+    if (!out) {
+        throw std::runtime_error("Error writing " + name);
+    }
+
+    m_samples_written += m_winners.size();
+    m_shard_count++;
+    m_winners.clear();
+    m_weights.clear();
+    m_probabilities.clear();
+    m_planes.clear();
+}
@@ -0,0 +1,115 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHUNKSHUFFLER_H_INCLUDED
+#define CHUNKSHUFFLER_H_INCLUDED
+
+#include "config.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Network.h"
+#include "Training.h"
+
+// One position of a training chunk, as written by Training::dump_training.
+struct ChunkSample {
+    // The side to move planes are implied by to_move.
+    static constexpr auto STONE_PLANES = Network::INPUT_CHANNELS - 2;
+
+    std::array<TimeStep::BoardPlane, STONE_PLANES> planes;
+    std::array<float, POTENTIAL_MOVES> probabilities;
+    int to_move;
+    // 1 if the side to move won, -1 otherwise. The mean over all
+    // occurrences for merged samples.
+    float winner;
+    // The number of occurrences a merged sample stands for.
+    float weight{1.0f};
+
+    ChunkSample apply_symmetry(int symmetry) const;
+    // Hash of the current position (not the history) after applying
+    // symmetry. Needs the Zobrist tables set up as in leelaz.
+    std::uint64_t get_symmetry_hash(int symmetry) const;
+};
+
+/*
+    Turns training chunks into shuffled tensor shards the trainer can
+    map into memory without any decoding.
+
+    Samples go through a reservoir of shuffle_size samples: each new
+    sample swaps places with a random one already in it, and once the
+    reservoir is full the displaced sample is written out.
+
+    A shard is prefix.N.shard, all in native byte order:
+        ShardHeader
+        float   winner[count]
+        float   weight[count]
+        float   probabilities[count][POTENTIAL_MOVES]
+        uint8_t planes[count][INPUT_CHANNELS][NUM_INTERSECTIONS]
+    Every shard holds shard_size samples except possibly the last.
+*/
+class ChunkShuffler {
+public:
+    struct ShardHeader {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t board_size;
+        std::uint32_t input_channels;
+        std::uint32_t count;
+    };
+    static constexpr std::uint32_t SHARD_VERSION = 2;
+
+    ChunkShuffler(const std::string& prefix,
+                  size_t shuffle_size, size_t shard_size);
+
+    // Reads a (gzipped) chunk file. Malformed positions are skipped.
+    // Safe to call from several threads.
+    static std::vector<ChunkSample> load_chunk(const std::string& filename);
+    // Each sample in all 8 symmetries, or in a single random one.
+    static std::vector<ChunkSample> augment(
+        const std::vector<ChunkSample>& samples, bool all_symmetries);
+
+    void add(const std::vector<ChunkSample>& samples);
+    // Empties the reservoir and writes the last shard.
+    void finish();
+
+    size_t get_samples_written() const { return m_samples_written; }
+    size_t get_shards_written() const { return m_shard_count; }
+
+private:
+    void insert(const ChunkSample& sample);
+    void write(const ChunkSample& sample);
+    void flush_shard();
+
+    std::string m_prefix;
+    size_t m_shuffle_size;
+    size_t m_shard_size;
+    std::vector<ChunkSample> m_reservoir;
+
+    std::vector<float> m_winners;
+    std::vector<float> m_weights;
+    std::vector<float> m_probabilities;
+    std::vector<std::uint8_t> m_planes;
+    size_t m_shard_count{0};
+    size_t m_samples_written{0};
+};
+
+#endif
@@ -30,14 +30,18 @@
 #include <random>
 #include <vector>
 #include <string>
+#include <thread>
 #include <vector>
 #include <boost/algorithm/string.hpp>
 
 #include "GTP.h"
+#include "Adjudicator.h"
 #include "FastBoard.h"
 #include "FullBoard.h"
+#include "GameArchive.h"
 #include "GameState.h"
 #include "Network.h"
+#include "PerfCounters.h"
 #include "SGFTree.h"
 #include "SMP.h"
 #include "Training.h"
@@ -57,9 +61,18 @@ int cfg_max_visits;
 size_t cfg_max_memory;
 size_t cfg_max_tree_size;
 int cfg_max_cache_ratio_percent;
+int cfg_prefetch;
+int cfg_fast_eval_visits;
+int cfg_virtual_loss;
+int cfg_ponder_s_pct;
 TimeManagement::enabled_t cfg_timemanage;
 int cfg_lagbuffer_cs;
 int cfg_resignpct;
+int cfg_adjudicate_pct;
+int cfg_adjudicate_moves;
+int cfg_adjudicate_playout_pct;
+int cfg_fast_playouts;
+int cfg_full_search_pct;
 int cfg_noise;
 int cfg_random_cnt;
 int cfg_random_min_visits;
@@ -80,13 +93,30 @@ float cfg_fpu_reduction;
 float cfg_fpu_root_reduction;
 std::string cfg_weightsfile;
 std::string cfg_weightsfile_s;
+bool cfg_policy_only_s;
 std::string cfg_logfile;
 FILE* cfg_logfile_handle;
 bool cfg_quiet;
 std::string cfg_options_str;
 bool cfg_benchmark;
+bool cfg_perf_counters;
 bool cfg_cpu_only;
+bool cfg_cpu_tune;
 int cfg_analyze_interval_centis;
+bool cfg_analyze_json;
+int cfg_analyze_cpu_pct;
+bool cfg_tree_cache;
+float cfg_strength_c;
+std::string cfg_match_weightsfile;
+float cfg_match_strength_c;
+int cfg_match_games;
+float cfg_match_elo0;
+float cfg_match_elo1;
+std::vector<float> cfg_calibrate_levels;
+std::vector<float> cfg_calibrate_anchors;
+float cfg_calibrate_margin;
+std::string cfg_calibrate_table;
+std::string cfg_archive_file;
 
 std::unique_ptr<Network> GTP::s_network;
 std::unique_ptr<Network> GTP::s_network_s;
@@ -128,10 +158,15 @@ void GTP::setup_default_parameters() {
     // This will be overwriiten in initialize() after network size is known.
     cfg_max_tree_size = UCTSearch::DEFAULT_MAX_MEMORY;
     cfg_max_cache_ratio_percent = 10;
+    cfg_prefetch = 0;
+    cfg_fast_eval_visits = 0;
+    cfg_virtual_loss = 0;
+    cfg_ponder_s_pct = 50;
     cfg_timemanage = TimeManagement::AUTO;
     cfg_lagbuffer_cs = 100;
     cfg_weightsfile = leelaz_file("best-network");
     cfg_weightsfile_s = cfg_weightsfile;
+    cfg_policy_only_s = false;
 #ifdef USE_OPENCL
     cfg_gpus = { };
     cfg_sgemm_exhaustive = false;
@@ -145,6 +180,11 @@ void GTP::setup_default_parameters() {
     cfg_fpu_reduction = 0.25f;
     // see UCTSearch::should_resign
     cfg_resignpct = -1;
+    cfg_adjudicate_pct = 0;
+    cfg_adjudicate_moves = 10;
+    cfg_adjudicate_playout_pct = 10;
+    cfg_fast_playouts = 0;
+    cfg_full_search_pct = 25;
     cfg_noise = false;
     cfg_fpu_root_reduction = cfg_fpu_reduction;
     cfg_random_cnt = 0;
@@ -154,13 +194,28 @@ void GTP::setup_default_parameters() {
     cfg_logfile_handle = nullptr;
     cfg_quiet = false;
     cfg_benchmark = false;
+    cfg_perf_counters = false;
 #ifdef USE_CPU_ONLY
     cfg_cpu_only = true;
 #else
     cfg_cpu_only = false;
 #endif
+    cfg_cpu_tune = false;
 
     cfg_analyze_interval_centis = 0;
+    cfg_analyze_json = false;
+    cfg_analyze_cpu_pct = 5;
+    cfg_tree_cache = false;
+
+    cfg_strength_c = 0.8f;
+    cfg_match_weightsfile = "";
+    cfg_match_strength_c = cfg_strength_c;
+    cfg_match_games = 400;
+    cfg_match_elo0 = 0.0f;
+    cfg_match_elo1 = 35.0f;
+    cfg_calibrate_margin = 50.0f;
+    cfg_calibrate_table = "calibration.txt";
+    cfg_archive_file = "";
 
     // C++11 doesn't guarantee *anything* about how random this is,
     // and in MinGW it isn't random at all. But we can mix it in, which
@@ -197,16 +252,21 @@ const std::string GTP::s_commands[] = {
         "set_free_handicap",
         "loadsgf",
         "printsgf",
+        "archive_game",
+        "archive_sgf",
         "kgs-genmove_cleanup",
         "kgs-time_settings",
         "kgs-game_over",
         "heatmap",
         "lz-analyze",
+        "lz-analyze-json",
         "lz-genmove_analyze",
         "lz-memory_report",
+        "lz-perf_counters",
         "lz-setoption",
         "autotrain",
         "check_running",
+        "lz-winrate",
         "lastMove"
         ""
 };
@@ -221,6 +281,7 @@ const std::string GTP::s_options[] = {
         "option name Lagbuffer type spin default 0 min 0 max 3000",
         "option name Resign Percentage type spin default -1 min -1 max 30",
         "option name Pondering type check default true",
+        "option name Tree Cache type check default false",
         ""
 };
 
@@ -254,9 +315,50 @@ std::string GTP::get_life_list(const GameState & game, bool live) {
     return result;
 }
 
+static std::unique_ptr<UCTSearch> make_search(GameState& game) {
+    auto search = std::make_unique<UCTSearch>(game, *GTP::s_network);
+    if (cfg_policy_only_s) {
+        search->set_policy_network(GTP::s_network_s.get());
+    }
+    if (cfg_fast_eval_visits > 0) {
+        search->set_fast_network(GTP::s_network_s.get());
+    }
+    return search;
+}
+
+// The archive games are appended to, kept open between games.
+static GameArchive& open_archive(const std::string& filename) {
+    static std::unique_ptr<GameArchive> archive;
+    if (!archive || archive->get_filename() != filename) {
+        archive = std::make_unique<GameArchive>(filename);
+    }
+    return *archive;
+}
+
+// Think on the opponent's time after our move. The strength-control
+// search ponders alongside the main one, on its share of the threads,
+// so both trees are warm for the next genmove. Both stop when input
+// arrives.
+static void ponder(UCTSearch& search, UCTSearch& search_s) {
+    if (cfg_policy_only_s || cfg_ponder_s_pct <= 0 || cfg_num_threads < 2) {
+        search.ponder(cfg_num_threads);
+        return;
+    }
+    const auto threads_s = std::min(
+        cfg_num_threads - 1,
+        std::max(1, cfg_num_threads * cfg_ponder_s_pct / 100));
+    const auto threads = cfg_num_threads - threads_s;
+    // Use a thread of our own, the pool runs the search workers.
+    auto ponder_s = std::thread([&search_s, threads_s]() {
+        search_s.ponder(threads_s, false);
+    });
+    search.ponder(threads);
+    ponder_s.join();
+}
+
 void GTP::execute(GameState & game, const std::string& xinput) {
     std::string input;
-    static auto search = std::make_unique<UCTSearch>(game, *s_network);
+    static auto search = make_search(game);
     static auto search_s = std::make_unique<UCTSearch>(game, *s_network_s);
 
     bool transform_lowercase = true;
@@ -371,7 +473,8 @@ void GTP::execute(GameState & game, const std::string& xinput) {
     } else if (command.find("clear_board") == 0) {
         Training::clear_training();
         game.reset_game();
-        search = std::make_unique<UCTSearch>(game, *s_network);
+        search = make_search(game);
+        search_s = std::make_unique<UCTSearch>(game, *s_network_s);
         assert(UCTNodePointer::get_tree_size() == 0);
         gtp_printf(id, "");
         return;
@@ -447,7 +550,9 @@ void GTP::execute(GameState & game, const std::string& xinput) {
             {
                 game.set_to_move(who);
                 // Outputs winrate and pvs for lz-genmove_analyze
-                search_s->think_s(who);
+                if (!cfg_policy_only_s) {
+                    search_s->think_s(who);
+                }
 
                 //=======================888=======================
 
@@ -456,7 +561,10 @@ void GTP::execute(GameState & game, const std::string& xinput) {
 
                 std::string candidatesString = "";
 
-                for (const auto& child : search->think_s(who)) {
+                // Search once, the children are used for the candidate
+                // list and the move.
+                const auto& children = search->think_s(who);
+                for (const auto& child : children) {
 //                    index++;
                     if(child->get_visits()>0) {
                         int visitCount = child->get_visits();
@@ -486,10 +594,11 @@ void GTP::execute(GameState & game, const std::string& xinput) {
 
                 std::string last_comments = search->get_last_comments(who);
 
-                game.play_move(who, search->think_s(who).front().get_move(),last_comments);
+                const auto bestmove = children.front().get_move();
+                game.play_move(who, bestmove, last_comments);
 //                game.set_last_move_canidates(candidates);
 
-                std::string vertex = game.move_to_text(search->think_s(who).front().get_move());
+                std::string vertex = game.move_to_text(bestmove);
                 if (!analysis_output) {
                     gtp_printf(id, "%s", vertex.c_str());
                 } else {
@@ -500,7 +609,7 @@ void GTP::execute(GameState & game, const std::string& xinput) {
                 // now start pondering
                 if (!game.has_resigned()) {
                     // Outputs winrate and pvs through gtp for lz-genmove_analyze
-                    search->ponder();
+                    ponder(*search, *search_s);
                 }
             }
             if (analysis_output) {
@@ -516,6 +625,8 @@ void GTP::execute(GameState & game, const std::string& xinput) {
         std::istringstream cmdstream(command);
         std::string tmp;
         auto who = game.board.get_to_move();
+        // JSON lines from a separate thread instead of info lines.
+        const auto json = command.find("lz-analyze-json") == 0;
 
         cmdstream >> tmp; // eat lz-analyze
         cmdstream >> tmp; // eat side to move or interval
@@ -552,9 +663,12 @@ void GTP::execute(GameState & game, const std::string& xinput) {
         if (!game.has_resigned()) {
             // Outputs winrate and pvs through gtp
             game.set_to_move(who);
-            search->ponder();
+            cfg_analyze_json = json;
+            // Only the main search is shown, so it gets all threads.
+            search->ponder(cfg_num_threads);
         }
         cfg_analyze_interval_centis = 0;
+        cfg_analyze_json = false;
         // Terminate multi-line response
         gtp_printf_raw("\n");
         return;
@@ -587,7 +701,7 @@ void GTP::execute(GameState & game, const std::string& xinput) {
             if (cfg_allow_pondering) {
                 // now start pondering
                 if (!game.has_resigned()) {
-                    search->ponder();
+                    ponder(*search, *search_s);
                 }
             }
         } else {
@@ -670,13 +784,30 @@ void GTP::execute(GameState & game, const std::string& xinput) {
                 // KGS sends this after our move
                 // now start pondering
                 if (!game.has_resigned()) {
-                    search->ponder();
+                    ponder(*search, *search_s);
                 }
             }
         } else {
             gtp_fail_printf(id, "syntax not understood");
         }
         return;
+    } else if (command.find("lz-winrate") == 0) {
+        std::istringstream cmdstream(command);
+        std::string tmp, color;
+
+        cmdstream >> tmp >> color;
+
+        int who;
+        if (color == "w" || color == "white") {
+            who = FastBoard::WHITE;
+        } else if (color == "b" || color == "black") {
+            who = FastBoard::BLACK;
+        } else {
+            gtp_fail_printf(id, "syntax error");
+            return;
+        }
+        gtp_printf(id, "%.4f", search->get_root_eval(who));
+        return;
     }else if(command.find("check_running") == 0){
         gtp_printf_raw("%s\n", search->is_running()?"True":"False");
         return;
@@ -731,17 +862,34 @@ void GTP::execute(GameState & game, const std::string& xinput) {
         std::random_device rd;
         std::ranlux48 gen(rd());
 
+        auto adjudicator = Adjudicator{cfg_adjudicate_pct,
+                                       cfg_adjudicate_moves,
+                                       NUM_INTERSECTIONS / 2,
+                                       cfg_adjudicate_playout_pct};
+
         for(int i=0; i<1; i++) {
             int movecount = 0;
             int winner = 0;
             int random_move = gen() % 60;
+            adjudicator.new_game();
             search->set_playout_limit(gen() % 10 + 10);
             myprintf("random move for : %d\n", random_move);
+            int full_searches = 0;
             do {
                 if(random_move == movecount) {
                     Training::clear_training();
                     search->set_playout_limit(cfg_max_playouts);
                 }
+                if (cfg_fast_playouts > 0 && movecount >= random_move) {
+                    // Playout cap randomization: only a share of the
+                    // moves gets the full search and becomes training
+                    // data, the rest just move the game along.
+                    auto full = int(gen() % 100) < cfg_full_search_pct;
+                    search->set_playout_limit(full ? cfg_max_playouts
+                                                   : cfg_fast_playouts);
+                    search->set_record_training(full);
+                    full_searches += full;
+                }
                 int move = search->think(game.get_to_move(), UCTSearch::NORMAL);
                 game.play_move(move);
                 game.display_state();
@@ -751,6 +899,14 @@ void GTP::execute(GameState & game, const std::string& xinput) {
                     winner = 1 - game.who_resigned();
                     break;
                 }
+                auto adjudicated = adjudicator.add_move(
+                    search->get_root_eval(FastBoard::BLACK),
+                    game.final_score());
+                if (adjudicated != Adjudicator::NONE) {
+                    myprintf("Adjudicated after %d moves.\n", movecount);
+                    winner = adjudicated;
+                    break;
+                }
                 else if(movecount >= boardsize * boardsize *2) {
                     float ftmp = game.final_score();
                     if (ftmp < -0.1) {
@@ -779,10 +935,27 @@ void GTP::execute(GameState & game, const std::string& xinput) {
 
 
             myprintf("winner is : %s\n", winner ? "W" : "B");
+            if (cfg_fast_playouts > 0) {
+                myprintf("%d of %d moves searched fully.\n",
+                         full_searches, movecount);
+                search->set_playout_limit(cfg_max_playouts);
+                search->set_record_training(true);
+            }
 
             if(winner >= 0) {
                 Training::dump_training(winner, chunker);
             }
+            if (!cfg_archive_file.empty()) {
+                try {
+                    auto record = GameRecord::from_state(game,
+                                                         FastBoard::BLACK);
+                    // Self-play, both sides are the engine.
+                    record.white = record.black;
+                    open_archive(cfg_archive_file).append(record);
+                } catch (const std::exception& e) {
+                    myprintf("%s\n", e.what());
+                }
+            }
 
             // re-init new game
             float old_komi = game.get_komi();
@@ -1017,6 +1190,51 @@ void GTP::execute(GameState & game, const std::string& xinput) {
 
 
 
+        return;
+    } else if (command.find("archive_game") == 0) {
+        std::istringstream cmdstream(command);
+        std::string tmp, filename;
+
+        cmdstream >> tmp >> filename;  // eat archive_game
+
+        if (cmdstream.fail()) {
+            gtp_fail_printf(id, "syntax not understood");
+            return;
+        }
+        try {
+            auto& archive = open_archive(filename);
+            archive.append(GameRecord::from_state(game, 0));
+            gtp_printf(id, "%zu", archive.size() - 1);
+        } catch (const std::exception& e) {
+            gtp_fail_printf(id, "%s", e.what());
+        }
+        return;
+    } else if (command.find("archive_sgf") == 0) {
+        std::istringstream cmdstream(command);
+        std::string tmp, filename, sgf_filename;
+        size_t index;
+
+        cmdstream >> tmp >> filename >> index;  // eat archive_sgf
+
+        if (cmdstream.fail()) {
+            gtp_fail_printf(id, "syntax not understood");
+            return;
+        }
+        cmdstream >> sgf_filename;
+        try {
+            auto sgf_text = GameArchive{filename}.get(index).to_sgf();
+            // Same output as printsgf.
+            boost::replace_all(sgf_text, "\n\n", "\n");
+            if (sgf_filename.empty()) {
+                gtp_printf(id, "%s\n", sgf_text.c_str());
+            } else {
+                std::ofstream out(sgf_filename);
+                out << sgf_text;
+                gtp_printf(id, "");
+            }
+        } catch (const std::exception& e) {
+            gtp_fail_printf(id, "%s", e.what());
+        }
         return;
     } else if (command.find("load_training") == 0) {
         std::istringstream cmdstream(command);
@@ -1118,6 +1336,32 @@ void GTP::execute(GameState & game, const std::string& xinput) {
                    "Network with overhead: %d MiB / Search tree: %d MiB / Network cache: %d\n",
                    total / MiB, base_memory / MiB, tree_size / MiB, cache_size / MiB);
         return;
+    } else if (command.find("lz-perf_counters") == 0) {
+        std::istringstream cmdstream(command);
+        std::string tmp, action;
+
+        cmdstream >> tmp >> action;  // eat lz-perf_counters
+
+        if (action == "on") {
+            if (!PerfCounters::available()) {
+                gtp_fail_printf(id, "hardware counters not available");
+                return;
+            }
+            cfg_perf_counters = true;
+        } else if (action == "off") {
+            cfg_perf_counters = false;
+        } else if (action == "clear") {
+            PerfCounters::clear();
+        } else if (!action.empty()) {
+            gtp_fail_printf(id, "syntax not understood");
+            return;
+        }
+        if (action.empty()) {
+            gtp_printf(id, "%s", PerfCounters::report().c_str());
+        } else {
+            gtp_printf(id, "");
+        }
+        return;
     } else if (command.find("lz-setoption") == 0) {
         return execute_setoption(*search.get(), id, command);
     }
@@ -1327,6 +1571,19 @@ void GTP::execute_setoption(UCTSearch & search,
             return;
         }
         gtp_printf(id, "");
+    } else if (name == "tree cache") {
+        std::istringstream valuestream(value);
+        std::string toggle;
+        valuestream >> toggle;
+        if (toggle == "true") {
+            cfg_tree_cache = true;
+        } else if (toggle == "false") {
+            cfg_tree_cache = false;
+        } else {
+            gtp_fail_printf(id, "incorrect value");
+            return;
+        }
+        gtp_printf(id, "");
     } else if (name == "resign percentage") {
         std::istringstream valuestream(value);
         int resignpct;
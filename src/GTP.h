@@ -38,9 +38,18 @@ extern int cfg_max_visits;
 extern size_t cfg_max_memory;
 extern size_t cfg_max_tree_size;
 extern int cfg_max_cache_ratio_percent;
+extern int cfg_prefetch;
+extern int cfg_fast_eval_visits;
+extern int cfg_virtual_loss;
+extern int cfg_ponder_s_pct;
 extern TimeManagement::enabled_t cfg_timemanage;
 extern int cfg_lagbuffer_cs;
 extern int cfg_resignpct;
+extern int cfg_adjudicate_pct;
+extern int cfg_adjudicate_moves;
+extern int cfg_adjudicate_playout_pct;
+extern int cfg_fast_playouts;
+extern int cfg_full_search_pct;
 extern int cfg_noise;
 extern int cfg_random_cnt;
 extern int cfg_random_min_visits;
@@ -65,12 +74,29 @@ extern float cfg_fpu_root_reduction;
 extern std::string cfg_logfile;
 extern std::string cfg_weightsfile;
 extern std::string cfg_weightsfile_s;
+extern bool cfg_policy_only_s;
 extern FILE* cfg_logfile_handle;
 extern bool cfg_quiet;
 extern std::string cfg_options_str;
 extern bool cfg_benchmark;
+extern bool cfg_perf_counters;
 extern bool cfg_cpu_only;
+extern bool cfg_cpu_tune;
 extern int cfg_analyze_interval_centis;
+extern bool cfg_analyze_json;
+extern int cfg_analyze_cpu_pct;
+extern bool cfg_tree_cache;
+extern float cfg_strength_c;
+extern std::string cfg_match_weightsfile;
+extern float cfg_match_strength_c;
+extern int cfg_match_games;
+extern float cfg_match_elo0;
+extern float cfg_match_elo1;
+extern std::vector<float> cfg_calibrate_levels;
+extern std::vector<float> cfg_calibrate_anchors;
+extern float cfg_calibrate_margin;
+extern std::string cfg_calibrate_table;
+extern std::string cfg_archive_file;
 
 static constexpr size_t MiB = 1024LL * 1024LL;
 
@@ -0,0 +1,409 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include "GameArchive.h"
+
+#include <boost/filesystem.hpp>
+#include <cassert>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "FastBoard.h"
+#include "GTP.h"
+#include "zlib.h"
+
+namespace fs = boost::filesystem;
+
+constexpr int GameRecord::PASS;
+
+namespace {
+
+constexpr std::uint8_t RECORD_VERSION = 1;
+constexpr std::uint16_t NO_MOVE = 0xFFFF;
+
+class Writer {
+public:
+    template<typename T>
+    void put(T value) {
+        m_data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void put_string(const std::string& value) {
+        put(std::uint32_t(value.size()));
+        m_data.append(value);
+    }
+    const std::string& data() const { return m_data; }
+private:
+    std::string m_data;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string& data) : m_data(data) {}
+    template<typename T>
+    T get() {
+        auto value = T{};
+        std::memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
+    }
+    std::string get_string() {
+        const auto size = get<std::uint32_t>();
+        return std::string(take(size), size);
+    }
+private:
+    const char* take(size_t size) {
+        if (m_pos + size > m_data.size()) {
+            throw std::runtime_error("Truncated game record");
+        }
+        const auto data = m_data.data() + m_pos;
+        m_pos += size;
+        return data;
+    }
+    const std::string& m_data;
+    size_t m_pos{0};
+};
+
+std::string sgf_coordinate(int coordinate) {
+    if (coordinate <= 25) {
+        return std::string(1, static_cast<char>('a' + coordinate));
+    }
+    return std::string(1, static_cast<char>('A' + coordinate - 26));
+}
+
+// The same text as FastBoard::move_to_text_sgf, without a board.
+std::string move_to_sgf(int move, int board_size) {
+    if (move == GameRecord::PASS) {
+        return "tt";
+    }
+    const auto x = move % board_size;
+    const auto y = move / board_size;
+    // SGF inverts rows
+    return sgf_coordinate(x) + sgf_coordinate(board_size - y - 1);
+}
+
+std::string serialize(const GameRecord& game) {
+    Writer out;
+    out.put(RECORD_VERSION);
+    out.put(std::uint8_t(game.board_size));
+    out.put(game.komi);
+    out.put_string(game.date);
+    out.put_string(game.time_control);
+    out.put_string(game.black);
+    out.put_string(game.white);
+    out.put_string(game.result);
+    out.put_string(game.options);
+    out.put(std::uint16_t(game.handicap.size()));
+    for (const auto stone : game.handicap) {
+        out.put(std::uint16_t(stone));
+    }
+    out.put(std::uint32_t(game.moves.size()));
+    for (const auto& move : game.moves) {
+        out.put(std::uint8_t(move.color));
+        out.put(move.move == GameRecord::PASS ? NO_MOVE
+                                              : std::uint16_t(move.move));
+        out.put_string(move.comment);
+    }
+    return out.data();
+}
+
+GameRecord deserialize(const std::string& data) {
+    Reader in(data);
+    if (in.get<std::uint8_t>() != RECORD_VERSION) {
+        throw std::runtime_error("Unknown game record version");
+    }
+    auto game = GameRecord{};
+    game.board_size = in.get<std::uint8_t>();
+    game.komi = in.get<float>();
+    game.date = in.get_string();
+    game.time_control = in.get_string();
+    game.black = in.get_string();
+    game.white = in.get_string();
+    game.result = in.get_string();
+    game.options = in.get_string();
+    game.handicap.resize(in.get<std::uint16_t>());
+    for (auto& stone : game.handicap) {
+        stone = in.get<std::uint16_t>();
+    }
+    game.moves.resize(in.get<std::uint32_t>());
+    for (auto& move : game.moves) {
+        move.color = in.get<std::uint8_t>();
+        const auto vertex = in.get<std::uint16_t>();
+        move.move = (vertex == NO_MOVE) ? GameRecord::PASS : int(vertex);
+        move.comment = in.get_string();
+    }
+    return game;
+}
+
+}
+
+GameRecord GameRecord::from_state(const GameState& game_state,
+                                  int compcolor) {
+    // make a working copy
+    auto state = std::make_unique<GameState>(game_state);
+    auto game = GameRecord{};
+
+    game.board_size = state->board.get_boardsize();
+    game.komi = state->get_komi();
+
+    time_t now;
+    time(&now);
+    char timestr[sizeof "2017-10-16"];
+    strftime(timestr, sizeof timestr, "%F", localtime(&now));
+    game.date = timestr;
+    game.time_control = state->get_timecontrol().to_text_sgf();
+
+    auto leela_name = std::string{PROGRAM_NAME};
+    leela_name.append(" " + std::string(PROGRAM_VERSION));
+    if (!cfg_weightsfile.empty()) {
+        auto pos = cfg_weightsfile.find_last_of("\\/");
+        if (std::string::npos == pos) {
+            pos = 0;
+        } else {
+            ++pos;
+        }
+        leela_name.append(" " + cfg_weightsfile.substr(pos, 8));
+    }
+    if (compcolor == FastBoard::WHITE) {
+        game.white = leela_name;
+        game.black = "Human";
+    } else {
+        game.black = leela_name;
+        game.white = "Human";
+    }
+    game.options = cfg_options_str;
+
+    state->rewind();
+
+    // check handicap here (anchor point)
+    const auto size = game.board_size;
+    for (auto i = 0; i < size; i++) {
+        for (auto j = 0; j < size; j++) {
+            const auto vertex = state->board.get_vertex(i, j);
+            if (state->board.get_state(vertex) == FastBoard::BLACK) {
+                game.handicap.emplace_back(i + j * size);
+            }
+        }
+    }
+
+    while (state->forward_move()) {
+        const auto vertex = state->get_last_move();
+        assert(vertex != FastBoard::RESIGN);
+        auto move = Move{};
+        move.color = state->board.black_to_move() ? FastBoard::WHITE
+                                                  : FastBoard::BLACK;
+        if (vertex == FastBoard::PASS) {
+            move.move = PASS;
+        } else {
+            const auto xy = state->board.get_xy(vertex);
+            move.move = xy.first + xy.second * size;
+        }
+        move.comment = state->get_last_comments();
+        game.moves.emplace_back(std::move(move));
+    }
+
+    if (!state->has_resigned()) {
+        const auto score = state->final_score();
+        std::ostringstream result;
+        result << std::fixed << std::setprecision(1);
+        if (score > 0.0f) {
+            result << "B+" << score;
+        } else if (score < 0.0f) {
+            result << "W+" << -score;
+        } else {
+            result << "0";
+        }
+        game.result = result.str();
+    } else if (state->who_resigned() == FastBoard::WHITE) {
+        game.result = "B+Resign";
+    } else {
+        game.result = "W+Resign";
+    }
+    return game;
+}
+
+std::string GameRecord::to_sgf() const {
+    std::ostringstream sgf;
+    sgf << "(;GM[1]FF[4]RU[Chinese]"
+        << "DT[" << date << "]"
+        << "SZ[" << board_size << "]"
+        << "KM[" << std::fixed << std::setprecision(1) << komi << "]"
+        << time_control
+        << "PB[" << black << "]"
+        << "PW[" << white << "]";
+    if (!handicap.empty()) {
+        sgf << "HA[" << handicap.size() << "]";
+    }
+    sgf << "RE[" << result << "]"
+        << "\nC[" << PROGRAM_NAME << " options:" << options << "]\n";
+
+    if (!handicap.empty()) {
+        sgf << "AB";
+        for (const auto stone : handicap) {
+            sgf << "[" << move_to_sgf(stone, board_size) << "]";
+        }
+    }
+    sgf << "\n";
+
+    auto counter = 0;
+    for (const auto& move : moves) {
+        sgf << (move.color == FastBoard::BLACK ? ";B[" : ";W[")
+            << move_to_sgf(move.move, board_size) << "]"
+            << move.comment;
+        if (++counter % 10 == 0) {
+            sgf << "\n";
+        }
+    }
+    sgf << ")\n";
+    return sgf.str();
+}
+
+GameArchive::GameArchive(const std::string& filename)
+    : m_filename(filename), m_index_filename(filename + ".idx") {
+    load_index();
+}
+
+void GameArchive::load_index() {
+    m_offsets.clear();
+    m_end = 0;
+    if (!fs::exists(m_filename)) {
+        return;
+    }
+    const auto archive_size = fs::file_size(m_filename);
+
+    auto in = std::ifstream{m_index_filename, std::ifstream::binary};
+    auto offset = std::uint64_t{0};
+    while (in.read(reinterpret_cast<char*>(&offset), sizeof(offset))) {
+        m_offsets.emplace_back(offset);
+    }
+
+    // The index is written after the record, so after a crash it can
+    // miss the last records.
+    auto indexed_size = std::uint64_t{0};
+    if (!m_offsets.empty()) {
+        auto data = std::ifstream{m_filename, std::ifstream::binary};
+        data.seekg(m_offsets.back());
+        auto header = EntryHeader{};
+        if (data.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            indexed_size = m_offsets.back() + sizeof(header)
+                           + header.compressed_size;
+        }
+    }
+    if (indexed_size != archive_size) {
+        rebuild_index();
+    } else {
+        m_end = archive_size;
+    }
+}
+
+void GameArchive::rebuild_index() {
+    m_offsets.clear();
+    auto in = std::ifstream{m_filename, std::ifstream::binary};
+    auto header = EntryHeader{};
+    auto offset = std::uint64_t{0};
+    while (in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        if (std::memcmp(header.magic, "LZGA", 4) != 0) {
+            throw std::runtime_error("Corrupt game archive " + m_filename);
+        }
+        in.seekg(header.compressed_size, std::ios::cur);
+        if (!in) {
+            // A record that was being written when we stopped.
+            break;
+        }
+        m_offsets.emplace_back(offset);
+        offset += sizeof(header) + header.compressed_size;
+    }
+    m_end = offset;
+
+    auto out = std::ofstream{m_index_filename, std::ofstream::binary};
+    out.write(reinterpret_cast<const char*>(m_offsets.data()),
+              m_offsets.size() * sizeof(std::uint64_t));
+}
+
+void GameArchive::append(const GameRecord& game) {
+    const auto data = serialize(game);
+    auto compressed_size = compressBound(data.size());
+    auto compressed = std::string(compressed_size, '\0');
+    const auto ret = compress2(
+        reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size,
+        reinterpret_cast<const Bytef*>(data.data()), data.size(),
+        Z_BEST_COMPRESSION);
+    if (ret != Z_OK) {
+        throw std::runtime_error("Error compressing game record");
+    }
+
+    auto offset = std::uint64_t{
+        fs::exists(m_filename) ? fs::file_size(m_filename) : 0};
+    if (offset != m_end) {
+        // Somebody else appended since.
+        load_index();
+        if (offset > m_end) {
+            // Drop a record that was being written when a writer died.
+            fs::resize_file(m_filename, m_end);
+            offset = m_end;
+        }
+    }
+    auto header = EntryHeader{{'L', 'Z', 'G', 'A'},
+                              static_cast<std::uint32_t>(data.size()),
+                              static_cast<std::uint32_t>(compressed_size)};
+    {
+        auto out = std::ofstream{m_filename,
+                                 std::ofstream::binary | std::ofstream::app};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(compressed.data(), compressed_size);
+        if (!out) {
+            throw std::runtime_error("Error writing " + m_filename);
+        }
+    }
+    auto index = std::ofstream{m_index_filename,
+                               std::ofstream::binary | std::ofstream::app};
+    index.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    m_offsets.emplace_back(offset);
+    m_end = offset + sizeof(header) + compressed_size;
+}
+
+GameRecord GameArchive::get(size_t index) const {
+    if (index >= m_offsets.size()) {
+        throw std::out_of_range("No game " + std::to_string(index)
+                                + " in " + m_filename);
+    }
+    auto in = std::ifstream{m_filename, std::ifstream::binary};
+    in.seekg(m_offsets[index]);
+    auto header = EntryHeader{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    auto compressed = std::string(header.compressed_size, '\0');
+    in.read(&compressed[0], compressed.size());
+    if (!in || std::memcmp(header.magic, "LZGA", 4) != 0) {
+        throw std::runtime_error("Corrupt game archive " + m_filename);
+    }
+
+    auto data = std::string(header.size, '\0');
+    auto size = uLongf{header.size};
+    const auto ret = uncompress(
+        reinterpret_cast<Bytef*>(&data[0]), &size,
+        reinterpret_cast<const Bytef*>(compressed.data()),
+        compressed.size());
+    if (ret != Z_OK || size != header.size) {
+        throw std::runtime_error("Corrupt game record in " + m_filename);
+    }
+    return deserialize(data);
+}
@@ -0,0 +1,92 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMEARCHIVE_H_INCLUDED
+#define GAMEARCHIVE_H_INCLUDED
+
+#include "config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GameState.h"
+
+// Everything the SGF of a finished game is made of.
+struct GameRecord {
+    struct Move {
+        int color;
+        // x + y * board_size as in FastBoard::get_xy, or PASS.
+        int move;
+        // The strength control candidates, as UCTNode::print_candidates
+        // wrote them.
+        std::string comment;
+    };
+    static constexpr auto PASS = -1;
+
+    int board_size;
+    float komi;
+    std::string date;
+    std::string time_control;
+    std::string black;
+    std::string white;
+    std::string result;
+    std::string options;
+    std::vector<int> handicap;
+    std::vector<Move> moves;
+
+    static GameRecord from_state(const GameState& state, int compcolor);
+    std::string to_sgf() const;
+};
+
+/*
+    Append-only file of compressed game records, with an index of
+    their offsets in filename.idx for random access. The index is
+    rebuilt from the records if it is missing or out of date.
+    All numbers are stored in native byte order.
+    Keep an instance around for appending many games, the index is only
+    read again if another writer changed the file in between.
+*/
+class GameArchive {
+public:
+    explicit GameArchive(const std::string& filename);
+
+    const std::string& get_filename() const { return m_filename; }
+    size_t size() const { return m_offsets.size(); }
+    void append(const GameRecord& game);
+    GameRecord get(size_t index) const;
+
+private:
+    struct EntryHeader {
+        char magic[4];
+        std::uint32_t size;
+        std::uint32_t compressed_size;
+    };
+
+    void load_index();
+    void rebuild_index();
+
+    std::string m_filename;
+    std::string m_index_filename;
+    std::vector<std::uint64_t> m_offsets;
+    // Size of the archive as far as the index covers it.
+    std::uint64_t m_end{0};
+};
+
+#endif
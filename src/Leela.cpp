@@ -25,15 +25,22 @@
 #include <boost/program_options.hpp>
 #include <cstdio>
 #include <cstdlib>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "CPUTuner.h"
+#include "Calibration.h"
 #include "GTP.h"
 #include "GameState.h"
+#include "Match.h"
 #include "Network.h"
 #include "NNCache.h"
+#include "PerfCounters.h"
 #include "Random.h"
 #include "ThreadPool.h"
 #include "Utils.h"
@@ -50,6 +57,20 @@ static void license_blurb() {
         PROGRAM_VERSION);
 }
 
+static std::vector<float> parse_float_list(const std::string& list) {
+    auto values = std::vector<float>{};
+    auto ss = std::stringstream{list};
+    auto item = std::string{};
+    while (std::getline(ss, item, ',')) {
+        try {
+            values.emplace_back(std::stof(item));
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+    return values;
+}
+
 static void parse_commandline(int argc, char *argv[]) {
     namespace po = boost::program_options;
     // Declare the supported options.
@@ -71,6 +92,8 @@ static void parse_commandline(int argc, char *argv[]) {
                         "-1 uses 10% but scales for handicap.")
         ("weights,w", po::value<std::string>()->default_value(cfg_weightsfile), "File with network weights.")
         ("weights_s,ws",po::value<std::string>()->default_value(cfg_weightsfile_s), "File with network_s file, used to mix.")
+        ("policy-only-s", "Only evaluate the root policy with the network_s "
+                          "for strength control, instead of a second search.")
         ("logfile,l", po::value<std::string>(), "File to log input/output to.")
         ("quiet,q", "Disable all diagnostic output.")
         ("timemanage", po::value<std::string>()->default_value("auto"),
@@ -81,9 +104,38 @@ static void parse_commandline(int argc, char *argv[]) {
                        "fast = Same as on but always plays faster.\n"
                        "no_pruning = For self play training use.\n")
         ("noponder", "Disable thinking on opponent's time.")
+        ("analyze-cpu-pct",
+         po::value<int>()->default_value(cfg_analyze_cpu_pct),
+         "Most of the wall time lz-analyze-json spends building its "
+         "output, in percent.")
+        ("tree-cache", "Keep the search trees of earlier positions for "
+                       "undo and navigating variations.")
+        ("ponder-s-pct", po::value<int>()->default_value(cfg_ponder_s_pct),
+                         "Percentage of the threads pondering on the "
+                         "strength-control network. 0 only ponders on "
+                         "the main network.")
+        ("prefetch", po::value<int>()->default_value(cfg_prefetch),
+                     "Evaluate the top x children of new nodes ahead of "
+                     "time on an extra thread. 0 disables.")
+        ("fast-eval-visits",
+            po::value<int>()->default_value(cfg_fast_eval_visits),
+            "Evaluate new nodes with the network_s and again with the "
+            "main network once they have this many visits or are on "
+            "the principal variation. 0 disables.")
+        ("virtual-loss", po::value<int>()->default_value(cfg_virtual_loss),
+                         "Virtual losses per thread on the nodes being "
+                         "searched. 0 tunes it from the collision rate.")
         ("benchmark", "Test network and exit. Default args:\n-v3200 --noponder "
                       "-m0 -t1 -s1.")
+        ("perf-counters", "Count cycles, instructions, cache and branch "
+                          "misses per search phase (Linux only). Shown "
+                          "after --benchmark and by lz-perf_counters.")
         ("cpu-only", "Use CPU-only implementation and do not use GPU.")
+        ("cpu-tune", "Benchmark CPU thread settings on the network and "
+                     "remember the fastest. --threads becomes the maximum.")
+        ("strength", po::value<float>()->default_value(cfg_strength_c),
+                     "Strength control parameter. Higher values play "
+                     "weaker moves more often.")
         ;
 #ifdef USE_OPENCL
     po::options_description gpu_desc("GPU options");
@@ -112,6 +164,54 @@ static void parse_commandline(int argc, char *argv[]) {
         ("randomtemp",
             po::value<float>()->default_value(cfg_random_temp),
             "Temperature to use for random move selection.")
+        ("adjudicate", po::value<int>()->default_value(cfg_adjudicate_pct),
+                       "autotrain: end the game when both sides and the "
+                       "area score agree a player wins with x% or more.\n"
+                       "0 disables adjudication.")
+        ("adjudicate-moves",
+            po::value<int>()->default_value(cfg_adjudicate_moves),
+            "Consecutive moves that must agree before adjudicating.")
+        ("adjudicate-playout",
+            po::value<int>()->default_value(cfg_adjudicate_playout_pct),
+            "Percentage of games that are played out regardless.")
+        ("fast-playouts",
+            po::value<int>()->default_value(cfg_fast_playouts),
+            "autotrain: playout cap for the moves that are not searched "
+            "fully. These moves are not used as training data. "
+            "0 searches every move fully.")
+        ("full-search-pct",
+            po::value<int>()->default_value(cfg_full_search_pct),
+            "Percentage of moves searched fully with --fast-playouts.")
+        ;
+    po::options_description match_desc("Match options");
+    match_desc.add_options()
+        ("match", po::value<std::string>(),
+                  "Play a match against the network in this file and exit.\n"
+                  "Runs --threads games at a time. Default args: -v3200.")
+        ("match-strength",
+            po::value<float>()->default_value(cfg_match_strength_c),
+            "Strength control parameter of the opponent.")
+        ("match-games", po::value<int>()->default_value(cfg_match_games),
+                        "Maximum number of games to play.")
+        ("match-sprt", po::value<std::string>(),
+                       "SPRT Elo bounds as lower:upper. Default is 0:35.")
+        ("archive", po::value<std::string>(),
+                    "Append the games of --match and of the autotrain "
+                    "GTP command to this game archive.")
+        ("calibrate", po::value<std::string>(),
+                      "Play a gauntlet of these comma separated strength "
+                      "parameters against the anchors, write an Elo table "
+                      "and exit. Uses the --match network for the anchors "
+                      "if given.")
+        ("calibrate-anchors", po::value<std::string>(),
+                              "Comma separated strength parameters of the "
+                              "anchors. Default is --match-strength.")
+        ("calibrate-margin",
+            po::value<float>()->default_value(cfg_calibrate_margin),
+            "Stop a pairing once its Elo is known within +- this.")
+        ("calibrate-table",
+            po::value<std::string>()->default_value(cfg_calibrate_table),
+            "File to write the Elo table to.")
         ;
 #ifdef USE_TUNER
     po::options_description tuner_desc("Tuning options");
@@ -132,6 +232,7 @@ static void parse_commandline(int argc, char *argv[]) {
        .add(gpu_desc)
 #endif
        .add(selfplay_desc)
+       .add(match_desc)
 #ifdef USE_TUNER
        .add(tuner_desc);
 #else
@@ -211,6 +312,10 @@ static void parse_commandline(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    if (vm.count("policy-only-s")) {
+        cfg_policy_only_s = true;
+    }
+
     if (vm.count("gtp")) {
         cfg_gtp_mode = true;
     }
@@ -269,10 +374,43 @@ static void parse_commandline(int argc, char *argv[]) {
     }
     myprintf("RNG seed: %llu\n", cfg_rng_seed);
 
+    if (vm.count("prefetch")) {
+        cfg_prefetch = std::max(0, vm["prefetch"].as<int>());
+    }
+
+    if (vm.count("fast-eval-visits")) {
+        cfg_fast_eval_visits = std::max(0, vm["fast-eval-visits"].as<int>());
+    }
+
+    if (vm.count("perf-counters")) {
+        cfg_perf_counters = true;
+        if (!PerfCounters::available()) {
+            myprintf("Hardware performance counters are not available.\n");
+        }
+    }
+
+    if (vm.count("tree-cache")) {
+        cfg_tree_cache = true;
+    }
+
+    if (vm.count("analyze-cpu-pct")) {
+        cfg_analyze_cpu_pct =
+            std::min(100, std::max(1, vm["analyze-cpu-pct"].as<int>()));
+    }
+
+    if (vm.count("virtual-loss")) {
+        cfg_virtual_loss = std::max(0, vm["virtual-loss"].as<int>());
+    }
+
     if (vm.count("noponder")) {
         cfg_allow_pondering = false;
     }
 
+    if (vm.count("ponder-s-pct")) {
+        cfg_ponder_s_pct =
+            std::min(100, std::max(0, vm["ponder-s-pct"].as<int>()));
+    }
+
     if (vm.count("noise")) {
         cfg_noise = true;
     }
@@ -321,6 +459,28 @@ static void parse_commandline(int argc, char *argv[]) {
         cfg_random_min_visits = vm["randomvisits"].as<int>();
     }
 
+    if (vm.count("adjudicate")) {
+        cfg_adjudicate_pct = vm["adjudicate"].as<int>();
+        cfg_adjudicate_moves = vm["adjudicate-moves"].as<int>();
+        cfg_adjudicate_playout_pct = vm["adjudicate-playout"].as<int>();
+        if (cfg_adjudicate_pct != 0
+            && (cfg_adjudicate_pct <= 50 || cfg_adjudicate_pct > 100)) {
+            printf("Invalid --adjudicate value, use 51-100 or 0.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (vm.count("fast-playouts")) {
+        cfg_fast_playouts = vm["fast-playouts"].as<int>();
+        cfg_full_search_pct = vm["full-search-pct"].as<int>();
+        if (cfg_fast_playouts < 0
+            || cfg_full_search_pct < 0 || cfg_full_search_pct > 100) {
+            printf("Nonsensical options: invalid playout cap "
+                   "randomization settings.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     if (vm.count("randomtemp")) {
         cfg_random_temp = vm["randomtemp"].as<float>();
     }
@@ -371,6 +531,80 @@ static void parse_commandline(int argc, char *argv[]) {
         }
     }
 
+    if (vm.count("strength")) {
+        cfg_strength_c = vm["strength"].as<float>();
+    }
+
+    if (vm.count("calibrate")) {
+        cfg_calibrate_levels = parse_float_list(vm["calibrate"].as<std::string>());
+        if (vm.count("calibrate-anchors")) {
+            cfg_calibrate_anchors =
+                parse_float_list(vm["calibrate-anchors"].as<std::string>());
+        } else {
+            cfg_calibrate_anchors = { vm["match-strength"].as<float>() };
+        }
+        if (cfg_calibrate_levels.empty() || cfg_calibrate_anchors.empty()) {
+            printf("Invalid --calibrate value, use a comma separated list "
+                   "of strength parameters.\n");
+            exit(EXIT_FAILURE);
+        }
+        cfg_calibrate_margin = vm["calibrate-margin"].as<float>();
+        cfg_calibrate_table = vm["calibrate-table"].as<std::string>();
+    }
+
+    if (vm.count("archive")) {
+        cfg_archive_file = vm["archive"].as<std::string>();
+    }
+
+    if (vm.count("match") || vm.count("calibrate")) {
+        if (vm.count("match")) {
+            cfg_match_weightsfile = vm["match"].as<std::string>();
+            if (!boost::filesystem::exists(cfg_match_weightsfile)) {
+                printf("Could not find the match network %s.\n",
+                       cfg_match_weightsfile.c_str());
+                exit(EXIT_FAILURE);
+            }
+        }
+        cfg_match_strength_c = vm["match-strength"].as<float>();
+        cfg_match_games = vm["match-games"].as<int>();
+        if (vm.count("match-sprt")) {
+            auto bounds = vm["match-sprt"].as<std::string>();
+            auto sep = bounds.find(':');
+            try {
+                if (sep == std::string::npos) {
+                    throw std::invalid_argument(bounds);
+                }
+                cfg_match_elo0 = std::stof(bounds.substr(0, sep));
+                cfg_match_elo1 = std::stof(bounds.substr(sep + 1));
+            } catch (const std::exception&) {
+                printf("Invalid --match-sprt value, use lower:upper.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (cfg_match_games < 1 || cfg_match_elo0 >= cfg_match_elo1) {
+            printf("Nonsensical match options.\n");
+            exit(EXIT_FAILURE);
+        }
+        cfg_quiet = true;
+        cfg_allow_pondering = false;
+        cfg_noise = false;
+        if (!vm.count("playouts") && !vm.count("visits")) {
+            cfg_max_visits = 3200; // Default to self-play and match values.
+        }
+    }
+
+    if (vm.count("cpu-tune")) {
+        if (!cfg_cpu_only) {
+            printf("Nonsensical options: --cpu-tune requires CPU-only "
+                   "evaluation. Add --cpu-only.\n");
+            exit(EXIT_FAILURE);
+        }
+        cfg_cpu_tune = true;
+        if (vm["threads"].defaulted()) {
+            cfg_num_threads = cfg_max_threads;
+        }
+    }
+
     // Do not lower the expected eval for root moves that are likely not
     // the best if we have introduced noise there exactly to explore more.
     cfg_fpu_root_reduction = cfg_noise ? 0.0f : cfg_fpu_reduction;
@@ -391,8 +625,18 @@ static void initialize_network() {
 
     auto playouts = std::min(cfg_max_playouts, cfg_max_visits);
 
+    // The networks are independent, so load the strength-control
+    // network while the primary one is loading.
+    auto network_s_loaded = std::async(std::launch::async,
+        [&network_s, playouts]() {
+            network_s->initialize(playouts, cfg_weightsfile_s);
+        });
     network->initialize(playouts, cfg_weightsfile);
-    network_s->initialize(playouts,cfg_weightsfile_s);
+    network_s_loaded.get();
+
+    if (cfg_cpu_tune) {
+        CPUTuner(*network).load_or_tune();
+    }
 
     GTP::initialize(std::move(network),std::move(network_s));
 }
@@ -413,6 +657,44 @@ void init_global_objects() {
     initialize_network();
 }
 
+void match() {
+    auto playouts = std::min(cfg_max_playouts, cfg_max_visits);
+    auto opponent = std::make_unique<Network>();
+    opponent->initialize(playouts, cfg_match_weightsfile);
+
+    auto first = Match::Player{cfg_weightsfile, GTP::s_network.get(), {}};
+    first.strength.c_param = cfg_strength_c;
+    auto second = Match::Player{cfg_match_weightsfile, opponent.get(), {}};
+    second.strength.c_param = cfg_match_strength_c;
+    if (first.name == second.name) {
+        first.name += " (c=" + std::to_string(cfg_strength_c) + ")";
+        second.name += " (c=" + std::to_string(cfg_match_strength_c) + ")";
+    }
+
+    Match match(first, second, cfg_match_games);
+    match.set_sprt(cfg_match_elo0, cfg_match_elo1);
+    if (!cfg_archive_file.empty()) {
+        match.set_archive(cfg_archive_file);
+    }
+    match.run(cfg_num_threads);
+}
+
+void calibrate() {
+    auto anchor_network = GTP::s_network.get();
+    auto opponent = std::unique_ptr<Network>{};
+    if (!cfg_match_weightsfile.empty()) {
+        auto playouts = std::min(cfg_max_playouts, cfg_max_visits);
+        opponent = std::make_unique<Network>();
+        opponent->initialize(playouts, cfg_match_weightsfile);
+        anchor_network = opponent.get();
+    }
+
+    Calibration calibration(GTP::s_network.get(), anchor_network,
+                            cfg_calibrate_levels, cfg_calibrate_anchors);
+    calibration.run(cfg_num_threads, cfg_match_games, cfg_calibrate_margin);
+    calibration.write_table(cfg_calibrate_table);
+}
+
 void benchmark(GameState& game) {
     game.set_timecontrol(0, 1, 0, 0);  // Set infinite time.
     game.play_textmove("b", "r16");
@@ -422,6 +704,10 @@ void benchmark(GameState& game) {
     auto search = std::make_unique<UCTSearch>(game, *GTP::s_network);
     game.set_to_move(FastBoard::WHITE);
     search->think(FastBoard::WHITE);
+
+    if (cfg_perf_counters) {
+        myprintf("\n%s\n", PerfCounters::report().c_str());
+    }
 }
 
 int main(int argc, char *argv[]) {
@@ -440,11 +726,28 @@ int main(int argc, char *argv[]) {
     setbuf(stdin, nullptr);
 #endif
 
-    if (!cfg_gtp_mode && !cfg_benchmark) {
+    if (!cfg_gtp_mode && !cfg_benchmark && cfg_match_weightsfile.empty()
+        && cfg_calibrate_levels.empty()) {
         license_blurb();
     }
 
-    init_global_objects();
+    // Network::initialize throws on weights it can't load.
+    try {
+        init_global_objects();
+
+        if (!cfg_calibrate_levels.empty()) {
+            calibrate();
+            return 0;
+        }
+
+        if (!cfg_match_weightsfile.empty()) {
+            match();
+            return 0;
+        }
+    } catch (const std::runtime_error& e) {
+        myprintf("%s\n", e.what());
+        return EXIT_FAILURE;
+    }
 
     auto maingame = std::make_unique<GameState>();
 
@@ -0,0 +1,265 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include "LeelaApi.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "FastBoard.h"
+#include "GTP.h"
+#include "GameState.h"
+#include "Network.h"
+#include "Random.h"
+#include "UCTSearch.h"
+#include "Utils.h"
+#include "Zobrist.h"
+
+struct lz_engine {
+    std::unique_ptr<Network> network;
+    std::unique_ptr<Network> network_s;
+    GameState game;
+    std::unique_ptr<UCTSearch> search;
+    bool searched{false};
+    std::string error;
+};
+
+namespace {
+
+std::once_flag s_init_flag;
+std::string s_create_error;
+
+// The same setup leelaz does after parsing its command line.
+void init_library(int threads) {
+    GTP::setup_default_parameters();
+    cfg_quiet = true;
+    cfg_allow_pondering = false;
+    if (threads > 0) {
+        cfg_num_threads = std::min(threads, cfg_max_threads);
+    }
+    thread_pool.initialize(cfg_num_threads);
+
+    // Use deterministic random numbers for hashing
+    auto rng = std::make_unique<Random>(5489);
+    Zobrist::init_zobrist(*rng);
+    Random::get_Rng().seedrandom(cfg_rng_seed);
+}
+
+bool file_exists(const char* name) {
+    return std::ifstream(name).good();
+}
+
+std::unique_ptr<Network> load_network(const char* weights) {
+    auto network = std::make_unique<Network>();
+    network->initialize(std::min(cfg_max_playouts, cfg_max_visits),
+                        weights);
+    return network;
+}
+
+int vertex_to_move(const GameState& game, int vertex) {
+    if (vertex == FastBoard::PASS) {
+        return LZ_PASS;
+    } else if (vertex == FastBoard::RESIGN) {
+        return LZ_RESIGN;
+    }
+    const auto xy = game.board.get_xy(vertex);
+    return xy.first + xy.second * BOARD_SIZE;
+}
+
+bool valid_move(int move) {
+    return move == LZ_PASS || (move >= 0 && move < NUM_INTERSECTIONS);
+}
+
+int move_to_vertex(const GameState& game, int move) {
+    if (move == LZ_PASS) {
+        return FastBoard::PASS;
+    }
+    return game.board.get_vertex(move % BOARD_SIZE, move / BOARD_SIZE);
+}
+
+int fail(lz_engine* engine, const std::string& message) {
+    engine->error = message;
+    return -1;
+}
+
+}
+
+lz_engine* lz_engine_create(const char* weights, const char* weights_s,
+                            int threads) {
+    try {
+        std::call_once(s_init_flag, init_library, threads);
+
+        if (!weights || !file_exists(weights)) {
+            s_create_error = "weights file not found";
+            return nullptr;
+        }
+        if (weights_s && !file_exists(weights_s)) {
+            s_create_error = "strength-control weights file not found";
+            return nullptr;
+        }
+
+        auto engine = std::make_unique<lz_engine>();
+        engine->network = load_network(weights);
+        if (weights_s) {
+            engine->network_s = load_network(weights_s);
+        }
+        engine->game.init_game(BOARD_SIZE, 7.5f);
+        engine->search = std::make_unique<UCTSearch>(engine->game,
+                                                     *engine->network);
+        if (engine->network_s) {
+            engine->search->set_policy_network(engine->network_s.get());
+            if (cfg_fast_eval_visits > 0) {
+                engine->search->set_fast_network(engine->network_s.get());
+            }
+        }
+        return engine.release();
+    } catch (const std::exception& e) {
+        s_create_error = e.what();
+        return nullptr;
+    }
+}
+
+void lz_engine_destroy(lz_engine* engine) {
+    delete engine;
+}
+
+const char* lz_engine_error(const lz_engine* engine) {
+    return engine ? engine->error.c_str() : s_create_error.c_str();
+}
+
+int lz_board_size(void) {
+    return BOARD_SIZE;
+}
+
+int lz_set_position(lz_engine* engine, const int* moves, int count,
+                    float komi) {
+    try {
+        auto& game = engine->game;
+        game.init_game(BOARD_SIZE, komi);
+        engine->searched = false;
+        for (auto i = 0; i < count; i++) {
+            const auto color = (i % 2 == 0) ? FastBoard::BLACK
+                                            : FastBoard::WHITE;
+            const auto vertex = valid_move(moves[i])
+                ? move_to_vertex(game, moves[i]) : FastBoard::RESIGN;
+            if (vertex == FastBoard::RESIGN
+                || !game.is_move_legal(color, vertex)) {
+                game.init_game(BOARD_SIZE, komi);
+                return fail(engine, "illegal move " + std::to_string(i + 1));
+            }
+            game.play_move(color, vertex);
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        return fail(engine, e.what());
+    }
+}
+
+int lz_search(lz_engine* engine, int visits, int playouts, int time_ms,
+              int* best_move) {
+    if (visits <= 0 && playouts <= 0 && time_ms <= 0) {
+        return fail(engine, "no search limit");
+    }
+    try {
+        auto& game = engine->game;
+        auto& search = *engine->search;
+        search.set_visit_limit(visits > 0 ? visits
+                                          : UCTSearch::UNLIMITED_PLAYOUTS);
+        search.set_playout_limit(playouts > 0 ? playouts
+                                              : UCTSearch::UNLIMITED_PLAYOUTS);
+        if (time_ms > 0) {
+            // One stone per byo-yomi period of the requested time.
+            game.set_timecontrol(0, time_ms / 10 + cfg_lagbuffer_cs, 1, 0);
+        } else {
+            game.set_timecontrol(0, 1, 0, 0);  // Set infinite time.
+        }
+
+        const auto move = search.think(game.get_to_move());
+        engine->searched = true;
+        if (best_move) {
+            *best_move = vertex_to_move(game, move);
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        return fail(engine, e.what());
+    }
+}
+
+int lz_get_candidates(lz_engine* engine, lz_candidate* candidates,
+                      int max_candidates) {
+    if (!engine->searched) {
+        return fail(engine, "no search to read candidates from");
+    }
+    try {
+        auto& game = engine->game;
+        const auto color = game.get_to_move();
+
+        // Static policy over the legal moves, as the strength control
+        // sees it.
+        auto& policy_network = engine->network_s ? *engine->network_s
+                                                 : *engine->network;
+        const auto raw = policy_network.get_output(
+            &game, Network::Ensemble::DIRECT, Network::IDENTITY_SYMMETRY);
+        auto legal_sum = raw.policy_pass;
+        for (auto i = 0; i < NUM_INTERSECTIONS; i++) {
+            const auto vertex = move_to_vertex(game, i);
+            if (game.is_move_legal(color, vertex)) {
+                legal_sum += raw.policy[i];
+            }
+        }
+        legal_sum = std::max(legal_sum, std::numeric_limits<float>::min());
+
+        auto searched = std::vector<lz_candidate>{};
+        for (const auto& child : engine->search->get_children()) {
+            if (!child.valid() || child.get_visits() == 0) {
+                continue;
+            }
+            const auto move = vertex_to_move(game, child.get_move());
+            auto candidate = lz_candidate{};
+            candidate.move = move;
+            candidate.visits = child.get_visits();
+            candidate.winrate = child.get_eval(color);
+            candidate.prior = child.get_policy();
+            candidate.static_policy =
+                (move == LZ_PASS ? raw.policy_pass : raw.policy[move])
+                / legal_sum;
+            searched.emplace_back(candidate);
+        }
+        // get_children() orders by eval, best first means most visits.
+        std::stable_sort(begin(searched), end(searched),
+            [](const lz_candidate& a, const lz_candidate& b) {
+                if (a.visits != b.visits) {
+                    return a.visits > b.visits;
+                }
+                return a.winrate > b.winrate;
+            });
+        const auto count =
+            std::max(0, std::min(max_candidates, int(searched.size())));
+        std::copy_n(begin(searched), count, candidates);
+        return count;
+    } catch (const std::exception& e) {
+        return fail(engine, e.what());
+    }
+}
@@ -0,0 +1,88 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LEELAAPI_H_INCLUDED
+#define LEELAAPI_H_INCLUDED
+
+/*
+    C interface to the engine, for programs that link it as a library
+    instead of talking GTP to a leelaz process.
+
+    Moves are board indices x + y * lz_board_size(), with x counted
+    from the left and y from the bottom, or LZ_PASS / LZ_RESIGN.
+    Functions returning int return 0 on success and -1 on failure,
+    lz_engine_error() then describes the failure.
+
+    The first lz_engine_create() sets up the process wide state (thread
+    pool, hashing, defaults). Its thread count applies to all engines.
+    An engine must not be used from two threads at the same time, but
+    different engines can be.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LZ_PASS (-1)
+#define LZ_RESIGN (-2)
+
+typedef struct lz_engine lz_engine;
+
+typedef struct {
+    int move;
+    int visits;
+    /* Winrate for the side to move, after the search. */
+    float winrate;
+    /* Prior of the searched network. */
+    float prior;
+    /* Policy of the strength-control network. */
+    float static_policy;
+} lz_candidate;
+
+/* weights_s may be NULL to take the static policy from weights. */
+lz_engine* lz_engine_create(const char* weights, const char* weights_s,
+                            int threads);
+void lz_engine_destroy(lz_engine* engine);
+const char* lz_engine_error(const lz_engine* engine);
+
+int lz_board_size(void);
+
+/* Clear the board and play moves[0..count), alternating from black. */
+int lz_set_position(lz_engine* engine, const int* moves, int count,
+                    float komi);
+
+/*
+    Search the side to move with the given limits, 0 means no limit
+    for that kind. The chosen move, with strength control applied, is
+    stored in best_move. It is not played.
+*/
+int lz_search(lz_engine* engine, int visits, int playouts, int time_ms,
+              int* best_move);
+
+/*
+    Copy up to max_candidates searched moves of the last search, best
+    first, into candidates. Returns how many were copied, or -1.
+*/
+int lz_get_candidates(lz_engine* engine, lz_candidate* candidates,
+                      int max_candidates);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
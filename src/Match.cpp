@@ -0,0 +1,213 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "FastBoard.h"
+#include "GameState.h"
+#include "GTP.h"
+#include "Match.h"
+#include "Timing.h"
+#include "UCTSearch.h"
+#include "Utils.h"
+
+Match::Match(const Player& first, const Player& second, int max_games)
+    : m_players{{first, second}}, m_max_games(max_games) {
+    m_sprt.initialize_estimate(0.0);
+    // Go games are (almost) never drawn, but the test needs a draw
+    // ratio to estimate the draw Elo. Start with a single draw.
+    m_sprt.add_game_result(Sprt::Draw);
+}
+
+void Match::set_sprt(double elo0, double elo1) {
+    m_sprt.initialize(elo0, elo1, 0.05, 0.05);
+}
+
+void Match::set_elo_margin(double margin) {
+    m_sprt.initialize_estimate(margin);
+}
+
+void Match::set_archive(const std::string& filename) {
+    m_archive = std::make_unique<GameArchive>(filename);
+}
+
+void Match::archive_game(const GameState& game, int first_color) {
+    if (!m_archive) {
+        return;
+    }
+    auto record = GameRecord::from_state(game, FastBoard::BLACK);
+    const auto first_black = (first_color == FastBoard::BLACK);
+    record.black = m_players[first_black ? 0 : 1].name;
+    record.white = m_players[first_black ? 1 : 0].name;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    try {
+        m_archive->append(record);
+    } catch (const std::exception& e) {
+        Utils::myprintf("%s\n", e.what());
+    }
+}
+
+std::pair<Sprt::GameResult, int> Match::play_game(int game_index) {
+    auto game = GameState{};
+    game.init_game(BOARD_SIZE, 7.5f);
+    game.set_timecontrol(0, 1, 0, 0);  // Set infinite time.
+
+    const int first_color =
+        (game_index % 2 == 0) ? FastBoard::BLACK : FastBoard::WHITE;
+
+    // Indexed by color.
+    std::array<std::unique_ptr<UCTSearch>, 2> search;
+    for (auto i = 0; i < 2; i++) {
+        const auto& player = m_players[i];
+        const int color = (i == 0) ? first_color : !first_color;
+        search[color] = std::make_unique<UCTSearch>(game, *player.network);
+        search[color]->set_strength(player.strength);
+        search[color]->set_record_training(false);
+    }
+
+    auto movecount = 0;
+    int winner = FastBoard::EMPTY;
+    auto draw = false;
+    do {
+        const auto color = game.get_to_move();
+        const auto move = search[color]->think(color);
+        game.play_move(move);
+        movecount++;
+
+        if (game.has_resigned()) {
+            winner = !game.who_resigned();
+        } else if (game.get_passes() >= 2
+                   || movecount >= NUM_INTERSECTIONS * 2) {
+            const auto score = game.final_score();
+            if (score > 0.1f) {
+                winner = FastBoard::BLACK;
+            } else if (score < -0.1f) {
+                winner = FastBoard::WHITE;
+            } else {
+                draw = true;
+            }
+        }
+    } while (winner == FastBoard::EMPTY && !draw && !m_stop);
+
+    if (winner == FastBoard::EMPTY && !draw) {
+        // Interrupted because the match is over.
+        return {Sprt::NoResult, movecount};
+    }
+    archive_game(game, first_color);
+    if (draw) {
+        return {Sprt::Draw, movecount};
+    }
+    return {winner == first_color ? Sprt::Win : Sprt::Loss, movecount};
+}
+
+void Match::add_result(int game_index, Sprt::GameResult result, int moves) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (result == Sprt::NoResult) {
+        return;
+    }
+    m_sprt.add_game_result(result);
+    m_games_played++;
+
+    const auto first_black = (game_index % 2 == 0);
+    const auto wdl = m_sprt.get_wdl();
+    const auto status = m_sprt.status();
+    printf("Game %d: %s (%s) %s in %d moves. W/D/L %d/%d/%d, ",
+           game_index + 1,
+           m_players[0].name.c_str(), first_black ? "B" : "W",
+           result == Sprt::Win ? "wins"
+               : result == Sprt::Loss ? "loses" : "draws",
+           moves,
+           std::get<0>(wdl), std::get<1>(wdl) - 1, std::get<2>(wdl));
+    if (m_sprt.is_estimate()) {
+        const auto elo = m_sprt.get_elo();
+        printf("Elo %.1f +- %.1f\n", elo.diff, elo.error);
+    } else {
+        printf("LLR %.2f [%.2f, %.2f]\n",
+               status.llr, status.lBound, status.uBound);
+    }
+    if (status.result != Sprt::Continue) {
+        m_stop = true;
+    }
+    if (m_games_played >= m_max_games) {
+        m_stop = true;
+    }
+}
+
+bool Match::play_next_game() {
+    if (m_stop) {
+        return false;
+    }
+    const auto game_index = m_next_game++;
+    if (game_index >= m_max_games) {
+        return false;
+    }
+    const auto result = play_game(game_index);
+    add_result(game_index, result.first, result.second);
+    return true;
+}
+
+Sprt::Result Match::run(int concurrency) {
+    printf("Match: %s vs %s, up to %d games, %d at a time.\n",
+           m_players[0].name.c_str(), m_players[1].name.c_str(),
+           m_max_games, concurrency);
+
+    // Every game gets one search thread. The games run on their own
+    // threads so the thread pool stays free for tree deletion.
+    const auto search_threads = cfg_num_threads;
+    cfg_num_threads = 1;
+
+    const Time start;
+    auto games = std::vector<std::thread>{};
+    for (auto i = 0; i < concurrency; i++) {
+        games.emplace_back([this]() {
+            while (play_next_game()) {}
+        });
+    }
+    for (auto& game : games) {
+        game.join();
+    }
+    const Time end;
+
+    cfg_num_threads = search_threads;
+
+    const auto status = m_sprt.status();
+    const auto wdl = m_sprt.get_wdl();
+    printf("%d games played in %.1f seconds. %s: %d wins, %d losses.\n",
+           m_games_played, Time::timediff_seconds(start, end),
+           m_players[0].name.c_str(), std::get<0>(wdl), std::get<2>(wdl));
+    if (status.result == Sprt::AcceptH1) {
+        printf("%s is better than %s.\n",
+               m_players[0].name.c_str(), m_players[1].name.c_str());
+    } else if (status.result == Sprt::AcceptH0) {
+        printf("%s is not better than %s.\n",
+               m_players[0].name.c_str(), m_players[1].name.c_str());
+    } else if (m_sprt.is_estimate()) {
+        const auto elo = m_sprt.get_elo();
+        printf("%s: Elo %.1f +- %.1f.\n",
+               m_players[0].name.c_str(), elo.diff, elo.error);
+    } else {
+        printf("No SPRT decision.\n");
+    }
+    return status.result;
+}
@@ -0,0 +1,94 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATCH_H_INCLUDED
+#define MATCH_H_INCLUDED
+
+#include "config.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "GameArchive.h"
+#include "Network.h"
+#include "SPRT.h"
+#include "UCTNode.h"
+
+/*
+    Plays games between two engine configurations inside one process,
+    without going through GTP. Several games run at the same time,
+    each with a single threaded search, and players using the same
+    network share its evaluation cache. Results feed an SPRT which
+    stops the match once either hypothesis is accepted, or, without
+    one, an Elo estimate.
+*/
+class Match {
+public:
+    struct Player {
+        std::string name;
+        Network* network;
+        StrengthParams strength;
+    };
+
+    // Plays max_games games and estimates the Elo difference.
+    Match(const Player& first, const Player& second, int max_games);
+
+    // Stop once the SPRT accepts H0 (elo0) or H1 (elo1).
+    void set_sprt(double elo0, double elo1);
+    // Stop as soon as the 95% confidence margin of the Elo difference
+    // is below margin.
+    void set_elo_margin(double margin);
+    // Append every finished game to this game archive.
+    void set_archive(const std::string& filename);
+
+    // Play the match with `concurrency` games at a time.
+    // Returns the final SPRT (or estimate) result.
+    Sprt::Result run(int concurrency);
+
+    // Play the next game of the match, if any. Returns false if the
+    // match is over. Can be called from several threads at once.
+    bool play_next_game();
+    bool finished() const { return m_stop; }
+    int games_started() const { return m_next_game; }
+
+    const Player& get_player(int index) const { return m_players[index]; }
+    const Sprt& get_sprt() const { return m_sprt; }
+
+private:
+    // Play one game, the first player takes black on even game indices.
+    // Returns the result from the point of view of the first player
+    // and the number of moves played.
+    std::pair<Sprt::GameResult, int> play_game(int game_index);
+    void add_result(int game_index, Sprt::GameResult result, int moves);
+    void archive_game(const GameState& game, int first_color);
+
+    std::array<Player, 2> m_players;
+    int m_max_games;
+    std::unique_ptr<GameArchive> m_archive;
+    Sprt m_sprt;
+    std::mutex m_mutex;
+    std::atomic<int> m_next_game{0};
+    std::atomic<bool> m_stop{false};
+    int m_games_played{0};
+};
+
+#endif
@@ -25,7 +25,9 @@
 #include <cmath>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <boost/utility.hpp>
 #include <boost/format.hpp>
@@ -57,6 +59,7 @@
 #include "GameState.h"
 #include "GTP.h"
 #include "NNCache.h"
+#include "PerfCounters.h"
 #include "Random.h"
 #include "ThreadPool.h"
 #include "Timing.h"
@@ -215,73 +218,81 @@ std::vector<float> Network::winograd_transform_f(const std::vector<float>& f,
 }
 
 std::pair<int, int> Network::load_v1_network(std::istream& wtfile) {
-    // Count size of the network
-    myprintf("Detecting residual layers...");
+    // Both networks may be loading at the same time, so build up the
+    // detection message and print it in one go.
+    auto detect = std::stringstream{};
+    detect << "Detecting residual layers...";
     // We are version 1 or 2
     if (m_value_head_not_stm) {
-        myprintf("v%d...", 2);
+        detect << "v2...";
     } else {
-        myprintf("v%d...", 1);
+        detect << "v1...";
     }
-    // First line was the version number
-    auto linecount = size_t{1};
-    auto channels = 0;
+    // First line was the version number, keep the rest in memory
+    // so we can parse the lines in parallel.
+    auto lines = std::vector<std::string>{};
     auto line = std::string{};
     while (std::getline(wtfile, line)) {
-        auto iss = std::stringstream{line};
-        // Third line of parameters are the convolution layer biases,
-        // so this tells us the amount of channels in the residual layers.
-        // We are assuming all layers have the same amount of filters.
-        if (linecount == 2) {
-            auto count = std::distance(std::istream_iterator<std::string>(iss),
-                                       std::istream_iterator<std::string>());
-            myprintf("%d channels...", count);
-            channels = count;
-        }
-        linecount++;
+        lines.emplace_back(std::move(line));
+    }
+    // Third line of parameters are the convolution layer biases,
+    // so this tells us the amount of channels in the residual layers.
+    // We are assuming all layers have the same amount of filters.
+    auto channels = 0;
+    if (lines.size() > 1) {
+        auto iss = std::stringstream{lines[1]};
+        channels = std::distance(std::istream_iterator<std::string>(iss),
+                                 std::istream_iterator<std::string>());
+        detect << channels << " channels...";
     }
     // 1 format id, 1 input layer (4 x weights), 14 ending weights,
     // the rest are residuals, every residual has 8 x weight lines
+    auto linecount = lines.size() + 1;
     auto residual_blocks = linecount - (1 + 4 + 14);
-    if (residual_blocks % 8 != 0) {
-        myprintf("\nInconsistent number of weights in the file.\n");
+    if (linecount < 1 + 4 + 14 || residual_blocks % 8 != 0) {
+        myprintf("%s\nInconsistent number of weights in the file.\n",
+                 detect.str().c_str());
         return {0, 0};
     }
     residual_blocks /= 8;
-    myprintf("%d blocks.\n", residual_blocks);
+    myprintf("%s%d blocks.\n", detect.str().c_str(), residual_blocks);
 
-    // Re-read file and process
-    wtfile.clear();
-    wtfile.seekg(0, std::ios::beg);
-
-    // Get the file format id out of the way
-    std::getline(wtfile, line);
+    // Parse every line on the thread pool
+    auto parsed = std::vector<std::vector<float>>(lines.size());
+    auto parsed_ok = std::vector<char>(lines.size(), false);
+    ThreadGroup tg(thread_pool);
+    for (auto i = size_t{0}; i < lines.size(); i++) {
+        tg.add_task([&lines, &parsed, &parsed_ok, i]() {
+            auto it_line = lines[i].cbegin();
+            const auto ok = phrase_parse(it_line, lines[i].cend(),
+                                         *x3::float_, x3::space, parsed[i]);
+            parsed_ok[i] = ok && it_line == lines[i].cend();
+        });
+    }
+    tg.wait_all();
+    lines.clear();
 
     const auto plain_conv_layers = 1 + (residual_blocks * 2);
     const auto plain_conv_wts = plain_conv_layers * 4;
-    linecount = 0;
-    while (std::getline(wtfile, line)) {
-        std::vector<float> weights;
-        auto it_line = line.cbegin();
-        const auto ok = phrase_parse(it_line, line.cend(),
-                                     *x3::float_, x3::space, weights);
-        if (!ok || it_line != line.cend()) {
+    for (linecount = 0; linecount < parsed.size(); linecount++) {
+        if (!parsed_ok[linecount]) {
             myprintf("\nFailed to parse weight file. Error on line %d.\n",
                     linecount + 2); //+1 from version line, +1 from 0-indexing
             return {0,0};
         }
+        auto& weights = parsed[linecount];
         if (linecount < plain_conv_wts) {
             if (linecount % 4 == 0) {
-                m_fwd_weights->m_conv_weights.emplace_back(weights);
+                m_fwd_weights->m_conv_weights.emplace_back(std::move(weights));
             } else if (linecount % 4 == 1) {
                 // Redundant in our model, but they encode the
                 // number of outputs so we have to read them in.
-                m_fwd_weights->m_conv_biases.emplace_back(weights);
+                m_fwd_weights->m_conv_biases.emplace_back(std::move(weights));
             } else if (linecount % 4 == 2) {
-                m_fwd_weights->m_batchnorm_means.emplace_back(weights);
+                m_fwd_weights->m_batchnorm_means.emplace_back(std::move(weights));
             } else if (linecount % 4 == 3) {
                 process_bn_var(weights);
-                m_fwd_weights->m_batchnorm_stddevs.emplace_back(weights);
+                m_fwd_weights->m_batchnorm_stddevs.emplace_back(std::move(weights));
             }
         } else {
             switch (linecount - plain_conv_wts) {
@@ -311,7 +322,6 @@ std::pair<int, int> Network::load_v1_network(std::istream& wtfile) {
                                    begin(m_ip2_val_b)); break;
             }
         }
-        linecount++;
     }
     process_bn_var(m_bn_pol_w2);
     process_bn_var(m_bn_val_w2);
@@ -482,42 +492,45 @@ void Network::initialize(int playouts, const std::string & weightsfile) {
     // explicitly set a maximum memory usage.
     m_nncache.set_size_from_playouts(playouts);
 
-    // Prepare symmetry table
-    for (auto s = 0; s < NUM_SYMMETRIES; ++s) {
-        for (auto v = 0; v < NUM_INTERSECTIONS; ++v) {
-            const auto newvtx =
-                get_symmetry({v % BOARD_SIZE, v / BOARD_SIZE}, s);
-            symmetry_nn_idx_table[s][v] =
-                (newvtx.second * BOARD_SIZE) + newvtx.first;
-            assert(symmetry_nn_idx_table[s][v] >= 0
-                   && symmetry_nn_idx_table[s][v] < NUM_INTERSECTIONS);
+    // Prepare symmetry table, shared by all networks
+    static std::once_flag symmetry_table_flag;
+    std::call_once(symmetry_table_flag, []() {
+        for (auto s = 0; s < NUM_SYMMETRIES; ++s) {
+            for (auto v = 0; v < NUM_INTERSECTIONS; ++v) {
+                const auto newvtx =
+                    get_symmetry({v % BOARD_SIZE, v / BOARD_SIZE}, s);
+                symmetry_nn_idx_table[s][v] =
+                    (newvtx.second * BOARD_SIZE) + newvtx.first;
+                assert(symmetry_nn_idx_table[s][v] >= 0
+                       && symmetry_nn_idx_table[s][v] < NUM_INTERSECTIONS);
+            }
         }
-    }
+    });
 
-    size_t channels, residual_blocks,channels_s,residual_blocks_s;
+    size_t channels, residual_blocks;
     std::tie(channels, residual_blocks) = load_network_file(weightsfile);
     if (channels == 0) {
-        exit(EXIT_FAILURE);
-    }
-
-    if (channels_s == 0) {
-        exit(EXIT_FAILURE);
+        throw std::runtime_error("Could not load weights file "
+                                 + weightsfile);
     }
-
-    auto weight_index = size_t{0};
-    // Input convolution
-    // Winograd transform convolution weights
-    m_fwd_weights->m_conv_weights[weight_index] =
-        winograd_transform_f(m_fwd_weights->m_conv_weights[weight_index],
-                             channels, INPUT_CHANNELS);
-    weight_index++;
-
-    // Residual block convolutions
-    for (auto i = size_t{0}; i < residual_blocks * 2; i++) {
-        m_fwd_weights->m_conv_weights[weight_index] =
-            winograd_transform_f(m_fwd_weights->m_conv_weights[weight_index],
-                                 channels, channels);
-        weight_index++;
+    m_channels = channels;
+    m_residual_blocks = residual_blocks;
+
+    // Winograd transform convolution weights, one layer per task.
+    // The input convolution comes first, then the residual blocks.
+    {
+        auto& conv_weights = m_fwd_weights->m_conv_weights;
+        ThreadGroup tg(thread_pool);
+        for (auto i = size_t{0}; i < 1 + residual_blocks * 2; i++) {
+            const auto layer_channels =
+                (i == 0 ? size_t{INPUT_CHANNELS} : channels);
+            tg.add_task([&conv_weights, i, channels, layer_channels]() {
+                conv_weights[i] = winograd_transform_f(conv_weights[i],
+                                                       channels,
+                                                       layer_channels);
+            });
+        }
+        tg.wait_all();
     }
 
     // Biases are not calculated and are typically zero but some networks might
@@ -545,6 +558,11 @@ void Network::initialize(int playouts, const std::string & weightsfile) {
         m_fwd_weights->m_conv_pol_b[i] = 0.0f;
     }
 
+    // Device setup tunes and benchmarks, which would be skewed
+    // by another network setting up at the same time.
+    static std::mutex init_mutex;
+    std::lock_guard<std::mutex> lock(init_mutex);
+
 #ifdef USE_OPENCL
     if (cfg_cpu_only) {
         myprintf("Initializing CPU-only evaluation.\n");
@@ -569,7 +587,6 @@ void Network::initialize(int playouts, const std::string & weightsfile) {
 #else //!USE_OPENCL
     myprintf("Initializing CPU-only evaluation.\n");
     m_forward = init_net(channels, std::make_unique<CPUPipe>());
-    m_forward_s = init_net(channels_s, std::make_unique<CPUPipe>());
 #endif
 
     // Need to estimate size before clearing up the pipe.
@@ -791,9 +808,14 @@ Network::Netresult Network::get_output_internal(
     constexpr auto width = BOARD_SIZE;
     constexpr auto height = BOARD_SIZE;
 
-    const auto input_data = gather_features(state, symmetry);
+    auto input_data = std::vector<float>{};
+    {
+        PerfCounters::Scope scope(PerfCounters::FEATURES);
+        input_data = gather_features(state, symmetry);
+    }
     std::vector<float> policy_data(OUTPUTS_POLICY * width * height);
     std::vector<float> value_data(OUTPUTS_VALUE * width * height);
+    PerfCounters::Scope scope(PerfCounters::FORWARD);
 #ifdef USE_OPENCL_SELFCHECK
     if (selfcheck) {
         m_forward_cpu->forward(input_data, policy_data, value_data);
@@ -89,6 +89,9 @@ public:
                                             const int symmetry,
                                             const int board_size = BOARD_SIZE);
 
+    int get_channels() const { return m_channels; }
+    int get_residual_blocks() const { return m_residual_blocks; }
+
     size_t get_estimated_size();
     size_t get_estimated_cache_size();
     void nncache_resize(int max_count);
@@ -129,7 +132,7 @@ private:
 #ifdef USE_HALF
     void select_precision(int channels);
 #endif
-    std::unique_ptr<ForwardPipe> m_forward,m_forward_s;
+    std::unique_ptr<ForwardPipe> m_forward;
 #ifdef USE_OPENCL_SELFCHECK
     void compare_net_outputs(const Netresult& data, const Netresult& ref);
     std::unique_ptr<ForwardPipe> m_forward_cpu;
@@ -139,6 +142,9 @@ private:
 
     size_t estimated_size{0};
 
+    int m_channels{0};
+    int m_residual_blocks{0};
+
     // Residual tower
     std::shared_ptr<ForwardPipeWeights> m_fwd_weights;
 
@@ -0,0 +1,251 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PerfCounters.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "GTP.h"
+
+using namespace PerfCounters;
+
+namespace {
+    enum Counter {
+        CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, NUM_COUNTERS
+    };
+    using Counts = std::array<std::uint64_t, NUM_COUNTERS>;
+
+    const char* const s_phase_names[NUM_PHASES] = {
+        "descent", "board", "features", "forward", "backup"
+    };
+
+    std::array<std::array<std::atomic<std::uint64_t>, NUM_COUNTERS>,
+               NUM_PHASES> s_totals;
+    std::array<std::atomic<std::uint64_t>, NUM_PHASES> s_calls;
+    // Counters some thread managed to open, the rest show up as "-".
+    std::atomic<int> s_opened{0};
+
+#ifdef __linux__
+    class ThreadCounters {
+    public:
+        ThreadCounters();
+        ~ThreadCounters();
+        bool ok() const { return m_fds[CYCLES] != -1; }
+        void enter(Phase phase);
+        void leave();
+
+    private:
+        Counts read_counts() const;
+        void charge(const Counts& now);
+
+        std::array<int, NUM_COUNTERS> m_fds;
+        // Position in the group read, the kernel leaves out
+        // the counters that failed to open.
+        std::array<int, NUM_COUNTERS> m_slots;
+        int m_num_open{0};
+        std::vector<Phase> m_phases;
+        Counts m_last{};
+    };
+
+    ThreadCounters::ThreadCounters() {
+        static constexpr std::uint64_t configs[NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+        m_fds.fill(-1);
+        m_slots.fill(-1);
+        for (auto c = 0; c < NUM_COUNTERS; c++) {
+            auto attr = perf_event_attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[c];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // The cycles counter leads the group, without it
+            // there are no numbers to compare against.
+            const auto fd = syscall(__NR_perf_event_open, &attr, 0, -1,
+                                    m_fds[CYCLES], 0);
+            if (fd < 0) {
+                if (c == CYCLES) {
+                    return;
+                }
+                continue;
+            }
+            m_fds[c] = int(fd);
+            m_slots[c] = m_num_open++;
+            s_opened.fetch_or(1 << c);
+        }
+        m_last = read_counts();
+    }
+
+    ThreadCounters::~ThreadCounters() {
+        for (auto fd : m_fds) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+    }
+
+    Counts ThreadCounters::read_counts() const {
+        // struct { u64 nr; u64 values[nr]; } for PERF_FORMAT_GROUP.
+        std::uint64_t buffer[1 + NUM_COUNTERS] = {};
+        auto counts = Counts{};
+        if (read(m_fds[CYCLES], buffer, sizeof(buffer)) <= 0) {
+            return m_last;
+        }
+        for (auto c = 0; c < NUM_COUNTERS; c++) {
+            if (m_slots[c] != -1) {
+                counts[c] = buffer[1 + m_slots[c]];
+            }
+        }
+        return counts;
+    }
+
+    void ThreadCounters::charge(const Counts& now) {
+        if (!m_phases.empty()) {
+            auto& totals = s_totals[m_phases.back()];
+            for (auto c = 0; c < NUM_COUNTERS; c++) {
+                totals[c].fetch_add(now[c] - m_last[c],
+                                    std::memory_order_relaxed);
+            }
+        }
+        m_last = now;
+    }
+
+    void ThreadCounters::enter(Phase phase) {
+        charge(read_counts());
+        m_phases.push_back(phase);
+        s_calls[phase].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ThreadCounters::leave() {
+        charge(read_counts());
+        m_phases.pop_back();
+    }
+
+    ThreadCounters& thread_counters() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+#endif
+}
+
+bool PerfCounters::available() {
+#ifdef __linux__
+    return thread_counters().ok();
+#else
+    return false;
+#endif
+}
+
+void PerfCounters::enter(Phase phase) {
+#ifdef __linux__
+    auto& counters = thread_counters();
+    if (counters.ok()) {
+        counters.enter(phase);
+    }
+#else
+    (void)phase;
+#endif
+}
+
+void PerfCounters::leave() {
+#ifdef __linux__
+    auto& counters = thread_counters();
+    if (counters.ok()) {
+        counters.leave();
+    }
+#endif
+}
+
+PerfCounters::Scope::Scope(Phase phase) : m_active(cfg_perf_counters) {
+    if (m_active) {
+        enter(phase);
+    }
+}
+
+PerfCounters::Scope::~Scope() {
+    if (m_active) {
+        leave();
+    }
+}
+
+void PerfCounters::clear() {
+    for (auto p = 0; p < NUM_PHASES; p++) {
+        for (auto& total : s_totals[p]) {
+            total = 0;
+        }
+        s_calls[p] = 0;
+    }
+}
+
+std::string PerfCounters::report() {
+    if (!available()) {
+        return "Hardware performance counters are not available.";
+    }
+    const auto opened = s_opened.load();
+    // Misses per thousand instructions.
+    auto per_kilo = [opened](std::uint64_t count, std::uint64_t instructions,
+                             Counter counter) {
+        char buffer[16];
+        if (!(opened & (1 << counter)) || !(opened & (1 << INSTRUCTIONS))
+            || !instructions) {
+            return std::string("-");
+        }
+        std::snprintf(buffer, sizeof(buffer), "%.2f",
+                      1000.0 * count / instructions);
+        return std::string(buffer);
+    };
+
+    auto result = std::string{};
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-10s %10s %12s %14s %6s %10s %10s",
+                  "phase", "calls", "cycles/call", "Mcycles", "IPC",
+                  "cache MPKI", "branch MPKI");
+    result += line;
+    for (auto p = 0; p < NUM_PHASES; p++) {
+        const auto calls = s_calls[p].load();
+        const auto cycles = s_totals[p][CYCLES].load();
+        const auto instructions = s_totals[p][INSTRUCTIONS].load();
+        const auto ipc = cycles && (opened & (1 << INSTRUCTIONS))
+                         ? double(instructions) / cycles : 0.0;
+        std::snprintf(line, sizeof(line),
+                      "\n%-10s %10llu %12.0f %14.1f %6.2f %10s %10s",
+                      s_phase_names[p], (unsigned long long)calls,
+                      calls ? double(cycles) / calls : 0.0, cycles / 1e6, ipc,
+                      per_kilo(s_totals[p][CACHE_MISSES].load(),
+                               instructions, CACHE_MISSES).c_str(),
+                      per_kilo(s_totals[p][BRANCH_MISSES].load(),
+                               instructions, BRANCH_MISSES).c_str());
+        result += line;
+    }
+    return result;
+}
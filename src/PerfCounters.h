@@ -0,0 +1,61 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFCOUNTERS_H_INCLUDED
+#define PERFCOUNTERS_H_INCLUDED
+
+#include "config.h"
+
+#include <string>
+
+/*
+    Hardware performance counters per engine phase, read with
+    perf_event_open on Linux. Every thread opens its own counter group
+    the first time it enters a phase, the differences between entering
+    and leaving are added to process wide totals. Nested phases are
+    charged exclusively: the outer phase is paused meanwhile.
+    Only user space is counted, so the reads themselves barely show up.
+    Does nothing unless cfg_perf_counters is set.
+*/
+namespace PerfCounters {
+    enum Phase {
+        DESCENT, BOARD_UPDATE, FEATURES, FORWARD, BACKUP, NUM_PHASES
+    };
+
+    // False if the counters can't be opened here, on other
+    // operating systems or with a too restrictive perf_event_paranoid.
+    bool available();
+    void clear();
+    // Table of the totals per phase, without a final newline.
+    std::string report();
+
+    void enter(Phase phase);
+    void leave();
+
+    class Scope {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        bool m_active;
+    };
+}
+
+#endif
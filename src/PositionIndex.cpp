@@ -0,0 +1,199 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PositionIndex.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "FastBoard.h"
+#include "Network.h"
+
+namespace fs = boost::filesystem;
+
+PositionIndex::PositionIndex(const std::string& directory, int partitions)
+    : m_directory(directory), m_partitions(std::max(partitions, 1)) {
+    fs::create_directories(m_directory);
+
+    // An existing index keeps the layout it was created with.
+    const auto info_name = (fs::path(m_directory) / "index.info").string();
+    auto info = std::ifstream{info_name};
+    if (info) {
+        auto board_size = 0;
+        info >> m_partitions >> board_size;
+        if (!info || m_partitions < 1 || board_size != BOARD_SIZE) {
+            throw std::runtime_error("Incompatible position index "
+                                     + m_directory);
+        }
+    } else {
+        auto out = std::ofstream{info_name};
+        out << m_partitions << ' ' << BOARD_SIZE << std::endl;
+    }
+    m_pending.resize(m_partitions);
+}
+
+PositionIndex::~PositionIndex() {
+    // Keep what was added, the next merge() picks it up.
+    try {
+        for (auto p = 0; p < m_partitions; p++) {
+            flush_pending(p);
+        }
+    } catch (...) {
+    }
+}
+
+std::string PositionIndex::partition_name(int partition,
+                                          const char* extension) const {
+    return (fs::path(m_directory)
+            / (std::to_string(partition) + extension)).string();
+}
+
+PositionIndex::Record PositionIndex::to_record(const ChunkSample& sample) {
+    auto canonical_symmetry = 0;
+    auto key = sample.get_symmetry_hash(0);
+    for (auto s = 1; s < Network::NUM_SYMMETRIES; s++) {
+        const auto hash = sample.get_symmetry_hash(s);
+        if (hash < key) {
+            key = hash;
+            canonical_symmetry = s;
+        }
+    }
+    const auto canonical = sample.apply_symmetry(canonical_symmetry);
+
+    auto record = Record{};
+    record.key = key;
+    record.count = 1;
+    record.wins = (canonical.winner > 0.0f);
+    record.to_move = canonical.to_move;
+    record.probabilities = canonical.probabilities;
+    for (auto p = 0; p < ChunkSample::STONE_PLANES; p++) {
+        for (auto v = 0; v < NUM_INTERSECTIONS; v++) {
+            if (canonical.planes[p][v]) {
+                record.planes[p][v / 8] |= 1 << (v % 8);
+            }
+        }
+    }
+    return record;
+}
+
+ChunkSample PositionIndex::to_sample(const Record& record) {
+    auto sample = ChunkSample{};
+    for (auto p = 0; p < ChunkSample::STONE_PLANES; p++) {
+        for (auto v = 0; v < NUM_INTERSECTIONS; v++) {
+            sample.planes[p][v] = record.planes[p][v / 8] & (1 << (v % 8));
+        }
+    }
+    for (auto i = size_t{0}; i < POTENTIAL_MOVES; i++) {
+        sample.probabilities[i] = record.probabilities[i] / record.count;
+    }
+    sample.to_move = record.to_move;
+    sample.winner = (2.0f * record.wins - record.count) / record.count;
+    sample.weight = float(record.count);
+    return sample;
+}
+
+void PositionIndex::add(const ChunkSample& sample) {
+    const auto record = to_record(sample);
+    const auto partition = int(record.key % m_partitions);
+    m_pending[partition].emplace_back(record);
+    if (m_pending[partition].size() >= PENDING_RECORDS) {
+        flush_pending(partition);
+    }
+}
+
+void PositionIndex::flush_pending(int partition) {
+    auto& pending = m_pending[partition];
+    if (pending.empty()) {
+        return;
+    }
+    const auto name = partition_name(partition, ".pending");
+    auto out = std::ofstream{name, std::ofstream::binary
+                                   | std::ofstream::app};
+    out.write(reinterpret_cast<const char*>(pending.data()),
+              pending.size() * sizeof(Record));
+    if (!out) {
+        throw std::runtime_error("Error writing " + name);
+    }
+    pending.clear();
+}
+
+void PositionIndex::merge() {
+    m_positions = 0;
+    m_unique_positions = 0;
+    for (auto p = 0; p < m_partitions; p++) {
+        flush_pending(p);
+        merge_partition(p);
+    }
+}
+
+void PositionIndex::merge_partition(int partition) {
+    const auto index_name = partition_name(partition, ".idx");
+    const auto pending_name = partition_name(partition, ".pending");
+
+    auto records = std::unordered_map<std::uint64_t, Record>{};
+    auto record = Record{};
+    for (const auto& name : {index_name, pending_name}) {
+        auto in = std::ifstream{name, std::ifstream::binary};
+        while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            auto it = records.find(record.key);
+            if (it == end(records)) {
+                records.emplace(record.key, record);
+                continue;
+            }
+            auto& merged = it->second;
+            merged.count += record.count;
+            merged.wins += record.wins;
+            for (auto i = size_t{0}; i < POTENTIAL_MOVES; i++) {
+                merged.probabilities[i] += record.probabilities[i];
+            }
+        }
+    }
+
+    // Replace the partition only once it is completely written.
+    const auto temp_name = partition_name(partition, ".tmp");
+    {
+        auto out = std::ofstream{temp_name, std::ofstream::binary};
+        for (const auto& entry : records) {
+            out.write(reinterpret_cast<const char*>(&entry.second),
+                      sizeof(Record));
+            m_positions += entry.second.count;
+        }
+        if (!out) {
+            throw std::runtime_error("Error writing " + temp_name);
+        }
+    }
+    fs::rename(temp_name, index_name);
+    fs::remove(pending_name);
+    m_unique_positions += records.size();
+}
+
+void PositionIndex::for_each(
+    const std::function<void(const ChunkSample&)>& f) const {
+
+    auto record = Record{};
+    for (auto p = 0; p < m_partitions; p++) {
+        auto in = std::ifstream{partition_name(p, ".idx"),
+                                std::ifstream::binary};
+        while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            f(to_sample(record));
+        }
+    }
+}
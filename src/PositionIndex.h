@@ -0,0 +1,91 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONINDEX_H_INCLUDED
+#define POSITIONINDEX_H_INCLUDED
+
+#include "config.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ChunkShuffler.h"
+
+/*
+    On-disk index of training positions that merges repeated positions
+    into one weighted sample.
+
+    Positions are keyed by the smallest of their 8 symmetry hashes and
+    stored in that symmetry, so the visit distributions of repeats line
+    up and can be summed along with their outcomes. The history planes
+    of the first occurrence are kept.
+
+    The keys are spread over a fixed number of partition files. New
+    samples are appended to a pending file of their partition, merge()
+    folds those into the partition one partition at a time, so only a
+    single partition has to fit in memory. The index is kept between
+    runs and can be added to.
+*/
+class PositionIndex {
+public:
+    PositionIndex(const std::string& directory, int partitions);
+    ~PositionIndex();
+
+    void add(const ChunkSample& sample);
+    // Folds everything added so far into the index.
+    void merge();
+    // Calls f with every position in the index.
+    void for_each(const std::function<void(const ChunkSample&)>& f) const;
+
+    // Totals as of the last merge().
+    size_t get_positions() const { return m_positions; }
+    size_t get_unique_positions() const { return m_unique_positions; }
+
+private:
+    static constexpr auto PLANE_BYTES = (NUM_INTERSECTIONS + 7) / 8;
+    static constexpr size_t PENDING_RECORDS = 64;
+
+    struct Record {
+        std::uint64_t key;
+        std::uint32_t count;
+        std::uint32_t wins;
+        std::uint32_t to_move;
+        // Sums over all occurrences.
+        std::array<float, POTENTIAL_MOVES> probabilities;
+        std::array<std::array<std::uint8_t, PLANE_BYTES>,
+                   ChunkSample::STONE_PLANES> planes;
+    };
+
+    static Record to_record(const ChunkSample& sample);
+    static ChunkSample to_sample(const Record& record);
+    std::string partition_name(int partition, const char* extension) const;
+    void flush_pending(int partition);
+    void merge_partition(int partition);
+
+    std::string m_directory;
+    int m_partitions;
+    std::vector<std::vector<Record>> m_pending;
+    size_t m_positions{0};
+    size_t m_unique_positions{0};
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <vector>
+
+#include "Prefetcher.h"
+#include "FastBoard.h"
+
+Prefetcher::Prefetcher(Network& network, size_t max_queue)
+    : m_network(network), m_max_queue(max_queue) {
+}
+
+Prefetcher::~Prefetcher() {
+    stop();
+}
+
+void Prefetcher::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_thread = std::thread(&Prefetcher::worker, this);
+}
+
+void Prefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        m_queue.clear();
+    }
+    m_condvar.notify_all();
+    m_thread.join();
+}
+
+void Prefetcher::prefetch_children(const GameState& state, UCTNode& node,
+                                   int count) {
+    auto moves = std::vector<int>{};
+    for (const auto move : node.get_child_moves()) {
+        if (static_cast<int>(moves.size()) >= count) {
+            break;
+        }
+        if (move != FastBoard::PASS) {
+            moves.emplace_back(move);
+        }
+    }
+    if (moves.empty()) {
+        return;
+    }
+
+    // Build the positions outside the lock, the search threads
+    // are waiting on it.
+    auto states = std::vector<std::unique_ptr<GameState>>{};
+    for (const auto move : moves) {
+        states.emplace_back(std::make_unique<GameState>(state));
+        states.back()->play_move(move);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        // Best child last, so it is served first.
+        for (auto it = states.rbegin(); it != states.rend(); ++it) {
+            m_queue.emplace_back(std::move(*it));
+        }
+        while (m_queue.size() > m_max_queue) {
+            m_queue.pop_front();
+        }
+    }
+    m_condvar.notify_one();
+}
+
+void Prefetcher::worker() {
+    for (;;) {
+        std::unique_ptr<GameState> state;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condvar.wait(lock, [this]{
+                return !m_running || !m_queue.empty();
+            });
+            if (!m_running) {
+                return;
+            }
+            state = std::move(m_queue.back());
+            m_queue.pop_back();
+        }
+        // Cached positions only cost a lookup.
+        m_network.get_output(state.get(), Network::Ensemble::RANDOM_SYMMETRY);
+        m_evaluations++;
+    }
+}
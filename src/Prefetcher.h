@@ -0,0 +1,69 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PREFETCHER_H_INCLUDED
+#define PREFETCHER_H_INCLUDED
+
+#include "config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "GameState.h"
+#include "Network.h"
+#include "UCTNode.h"
+
+/*
+    Speculatively evaluates the children a search thread is likely to
+    visit next, so the results are already in the NNCache when it gets
+    there. Requests go to a small queue served by one extra thread.
+    The newest requests are served first and the oldest are dropped
+    when the queue is full, because they are the least likely to
+    still be useful.
+*/
+class Prefetcher {
+public:
+    Prefetcher(Network& network, size_t max_queue);
+    ~Prefetcher();
+
+    void start();
+    // Drops the pending requests and waits for the thread.
+    void stop();
+    // Queue the first `count` children of node, which was just
+    // expanded from state. Children are sorted by policy.
+    void prefetch_children(const GameState& state, UCTNode& node, int count);
+    int get_evaluations() const { return m_evaluations; }
+
+private:
+    void worker();
+
+    Network& m_network;
+    size_t m_max_queue;
+    std::deque<std::unique_ptr<GameState>> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_condvar;
+    bool m_running{false};
+    std::thread m_thread;
+    std::atomic<int> m_evaluations{0};
+};
+
+#endif
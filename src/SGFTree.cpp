@@ -20,9 +20,7 @@
 #include "SGFTree.h"
 
 #include <cassert>
-#include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
-#include <ctime>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
@@ -32,6 +30,7 @@
 
 #include "FullBoard.h"
 #include "GTP.h"
+#include "GameArchive.h"
 #include "KoState.h"
 #include "SGFParser.h"
 #include "Utils.h"
@@ -394,117 +393,5 @@ std::vector<int> SGFTree::get_mainline() {
 }
 
 std::string SGFTree::state_to_string(GameState& pstate, int compcolor) {
-    auto state = std::make_unique<GameState>();
-
-    // make a working copy
-    *state = pstate;
-
-    std::string header;
-    std::string moves;
-
-    auto komi = state->get_komi();
-    auto size = state->board.get_boardsize();
-    time_t now;
-    time(&now);
-    char timestr[sizeof "2017-10-16"];
-    strftime(timestr, sizeof timestr, "%F", localtime(&now));
-
-    header.append("(;GM[1]FF[4]RU[Chinese]");
-    header.append("DT[" + std::string(timestr) + "]");
-    header.append("SZ[" + std::to_string(size) + "]");
-    header.append("KM[" + str(boost::format("%.1f") % komi) + "]");
-    header.append(state->get_timecontrol().to_text_sgf());
-
-    auto leela_name = std::string{PROGRAM_NAME};
-    leela_name.append(" " + std::string(PROGRAM_VERSION));
-    if (!cfg_weightsfile.empty()) {
-        auto pos = cfg_weightsfile.find_last_of("\\/");
-        if (std::string::npos == pos) {
-            pos = 0;
-        } else {
-            ++pos;
-        }
-        leela_name.append(" " + cfg_weightsfile.substr(pos, 8));
-    }
-
-    if (compcolor == FastBoard::WHITE) {
-        header.append("PW[" + leela_name + "]");
-        header.append("PB[Human]");
-    } else {
-        header.append("PB[" + leela_name + "]");
-        header.append("PW[Human]");
-    }
-
-    state->rewind();
-
-    // check handicap here (anchor point)
-    auto handicap = 0;
-    std::string handicapstr;
-
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            int vertex = state->board.get_vertex(i, j);
-            int vtx_state = state->board.get_state(vertex);
-
-            if (vtx_state == FastBoard::BLACK) {
-                handicap++;
-                handicapstr.append("[" + state->board.move_to_text_sgf(vertex) + "]");
-            }
-        }
-    }
-
-    if (handicap > 0) {
-        header.append("HA[" + std::to_string(handicap) + "]");
-        moves.append("AB" + handicapstr);
-    }
-
-    moves.append("\n");
-
-    int counter = 0;
-
-    while (state->forward_move()) {
-        int move = state->get_last_move();
-        std::string comments = state->get_last_comments();
-
-        assert(move != FastBoard::RESIGN);
-        std::string movestr = state->board.move_to_text_sgf(move);
-
-        if (state->board.black_to_move()) {
-            moves.append(";W[" + movestr + "]");
-        } else {
-            moves.append(";B[" + movestr + "]");
-        }
-
-        moves.append(comments);
-        if (++counter % 10 == 0) {
-            moves.append("\n");
-        }
-    }
-
-    if (!state->has_resigned()) {
-        float score = state->final_score();
-
-        if (score > 0.0f) {
-            header.append("RE[B+" + str(boost::format("%.1f") % score) + "]");
-        } else if (score < 0.0f) {
-            header.append("RE[W+" + str(boost::format("%.1f") % -score) + "]");
-        } else {
-            header.append("RE[0]");
-        }
-    } else {
-        if (state->who_resigned() == FastBoard::WHITE) {
-            header.append("RE[B+Resign]");
-        } else {
-            header.append("RE[W+Resign]");
-        }
-    }
-
-    header.append("\nC[" + std::string{PROGRAM_NAME} + " options:" + cfg_options_str + "]");
-
-    std::string result(header);
-    result.append("\n");
-    result.append(moves);
-    result.append(")\n");
-
-    return result;
+    return GameRecord::from_state(pstate, compcolor).to_sgf();
 }
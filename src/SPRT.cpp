@@ -0,0 +1,309 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Marco Calignano
+    originally taken from Cute Chess (http://github.com/cutechess)
+    Copyright (C) 2016 Ilari Pihlajisto
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "SPRT.h"
+
+namespace {
+
+class SprtProbability;
+
+class BayesElo {
+public:
+    BayesElo(double bayes_elo, double draw_elo)
+        : m_bayes_elo(bayes_elo), m_draw_elo(draw_elo) {}
+    explicit BayesElo(const SprtProbability& p);
+
+    double bayes_elo() const { return m_bayes_elo; }
+    double draw_elo() const { return m_draw_elo; }
+    double scale() const {
+        const auto x = std::pow(10.0, -m_draw_elo / 400.0);
+        return 4.0 * x / ((1.0 + x) * (1.0 + x));
+    }
+
+private:
+    double m_bayes_elo;
+    double m_draw_elo;
+};
+
+class SprtProbability {
+public:
+    SprtProbability(int wins, int losses, int draws) {
+        assert(wins > 0 && losses > 0 && draws > 0);
+        const auto count = wins + losses + draws;
+        m_p_win = double(wins) / count;
+        m_p_loss = double(losses) / count;
+        m_p_draw = 1.0 - m_p_win - m_p_loss;
+    }
+    explicit SprtProbability(const BayesElo& b) {
+        m_p_win = 1.0 / (1.0 + std::pow(10.0,
+                              (b.draw_elo() - b.bayes_elo()) / 400.0));
+        m_p_loss = 1.0 / (1.0 + std::pow(10.0,
+                               (b.draw_elo() + b.bayes_elo()) / 400.0));
+        m_p_draw = 1.0 - m_p_win - m_p_loss;
+    }
+
+    bool is_valid() const {
+        return 0.0 < m_p_win && m_p_win < 1.0
+            && 0.0 < m_p_loss && m_p_loss < 1.0
+            && 0.0 < m_p_draw && m_p_draw < 1.0;
+    }
+    double p_win() const { return m_p_win; }
+    double p_loss() const { return m_p_loss; }
+    double p_draw() const { return m_p_draw; }
+
+private:
+    double m_p_win;
+    double m_p_loss;
+    double m_p_draw;
+};
+
+double elo_diff(double score) {
+    // Keep lost causes finite.
+    score = std::min(std::max(score, 1e-4), 1.0 - 1e-4);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+BayesElo::BayesElo(const SprtProbability& p) {
+    assert(p.is_valid());
+    m_bayes_elo = 200.0 * std::log10(p.p_win() / p.p_loss()
+                                     * (1.0 - p.p_loss())
+                                     / (1.0 - p.p_win()));
+    m_draw_elo = 200.0 * std::log10((1.0 - p.p_loss()) / p.p_loss()
+                                    * (1.0 - p.p_win()) / p.p_win());
+}
+
+}
+
+void Sprt::initialize(double elo0, double elo1, double alpha, double beta) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_elo0 = elo0;
+    m_elo1 = elo1;
+    m_alpha = alpha;
+    m_beta = beta;
+    m_estimate = false;
+}
+
+void Sprt::initialize_estimate(double elo_margin) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_estimate = true;
+    m_elo_margin = elo_margin;
+}
+
+Sprt::Status Sprt::status() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_estimate) {
+        auto status = Status{Continue, 0.0, 0.0, 0.0};
+        if (m_elo_margin > 0.0 && elo_estimate().error < m_elo_margin) {
+            status.result = Estimated;
+        }
+        return status;
+    }
+    if (std::accumulate(begin(m_pairs), end(m_pairs), 0) > 0) {
+        return pentanomial_status();
+    }
+    return trinomial_status();
+}
+
+Sprt::Status Sprt::trinomial_status() const {
+    auto status = Status{Continue, 0.0, 0.0, 0.0};
+    status.lBound = std::log(m_beta / (1.0 - m_alpha));
+    status.uBound = std::log((1.0 - m_beta) / m_alpha);
+
+    if (m_wins <= 0 || m_losses <= 0 || m_draws <= 0) {
+        if (m_wins <= 0 && m_losses >= std::exp(std::fabs(status.lBound))) {
+            status.result = AcceptH0;
+        }
+        if (m_losses <= 0 && m_wins >= std::exp(std::fabs(status.uBound))) {
+            status.result = AcceptH1;
+        }
+        return status;
+    }
+    // Estimate draw_elo out of sample
+    const SprtProbability p(m_wins, m_losses, m_draws);
+    const BayesElo b(p);
+
+    // Probability laws under H0 and H1
+    const auto s = b.scale();
+    const BayesElo b0(m_elo0 / s, b.draw_elo());
+    const BayesElo b1(m_elo1 / s, b.draw_elo());
+    const SprtProbability p0(b0), p1(b1);
+
+    // Log-Likelyhood Ratio
+    status.llr = m_wins * std::log(p1.p_win() / p0.p_win())
+               + m_losses * std::log(p1.p_loss() / p0.p_loss())
+               + m_draws * std::log(p1.p_draw() / p0.p_draw());
+
+    // Bounds based on error levels of the test
+    if (status.llr > status.uBound) {
+        status.result = AcceptH1;
+    } else if (status.llr < status.lBound) {
+        status.result = AcceptH0;
+    }
+    return status;
+}
+
+Sprt::Status Sprt::pentanomial_status() const {
+    auto status = Status{Continue, 0.0, 0.0, 0.0};
+    status.lBound = std::log(m_beta / (1.0 - m_alpha));
+    status.uBound = std::log((1.0 - m_beta) / m_alpha);
+
+    // Empty bins would make the variance collapse after a few pairs.
+    auto counts = std::array<double, 5>{};
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] = m_pairs[i] > 0 ? m_pairs[i] : 1e-3;
+    }
+    const auto pairs = std::accumulate(begin(counts), end(counts), 0.0);
+
+    // Mean and variance of the pair score scaled to [0, 1].
+    auto mean = 0.0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        mean += counts[i] * (i / 4.0);
+    }
+    mean /= pairs;
+    auto variance = 0.0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        variance += counts[i] * std::pow(i / 4.0 - mean, 2);
+    }
+    variance /= pairs;
+    if (variance <= 0.0) {
+        return status;
+    }
+
+    // Expected scores under H0 and H1
+    const auto s0 = 1.0 / (1.0 + std::pow(10.0, -m_elo0 / 400.0));
+    const auto s1 = 1.0 / (1.0 + std::pow(10.0, -m_elo1 / 400.0));
+
+    status.llr = pairs * (s1 - s0) * (2.0 * mean - s0 - s1)
+               / (2.0 * variance);
+
+    if (status.llr > status.uBound) {
+        status.result = AcceptH1;
+    } else if (status.llr < status.lBound) {
+        status.result = AcceptH0;
+    }
+    return status;
+}
+
+void Sprt::count_game(GameResult result) {
+    if (result == Win) {
+        m_wins++;
+    } else if (result == Draw) {
+        m_draws++;
+    } else if (result == Loss) {
+        m_losses++;
+    }
+}
+
+void Sprt::add_game_result(GameResult result) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    count_game(result);
+}
+
+void Sprt::add_pair_result(GameResult first, GameResult second) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    count_game(first);
+    count_game(second);
+    auto half_points = 0;
+    for (const auto result : {first, second}) {
+        if (result == Win) {
+            half_points += 2;
+        } else if (result == Draw) {
+            half_points += 1;
+        }
+    }
+    m_pairs[half_points]++;
+}
+
+std::tuple<int, int, int> Sprt::get_wdl() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::make_tuple(m_wins, m_draws, m_losses);
+}
+
+std::array<int, 5> Sprt::get_pentanomial() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pairs;
+}
+
+Sprt::Elo Sprt::get_elo() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return elo_estimate();
+}
+
+Sprt::Elo Sprt::elo_estimate() const {
+    const auto count = double(m_wins + m_losses + m_draws);
+    if (count <= 0.0) {
+        return {0.0, 0.0};
+    }
+    const auto p_win = m_wins / count;
+    const auto p_loss = m_losses / count;
+    const auto p_draw = m_draws / count;
+    const auto score = p_win + p_draw / 2.0;
+
+    const auto dev_win = p_win * std::pow(1.0 - score, 2.0);
+    const auto dev_loss = p_loss * std::pow(0.0 - score, 2.0);
+    const auto dev_draw = p_draw * std::pow(0.5 - score, 2.0);
+    const auto stdev = std::sqrt(dev_win + dev_loss + dev_draw)
+                     / std::sqrt(count);
+
+    // 1.96 standard deviations for a 95% confidence interval.
+    const auto min = elo_diff(score - 1.959964 * stdev);
+    const auto max = elo_diff(score + 1.959964 * stdev);
+    return {elo_diff(score), (max - min) / 2.0};
+}
+
+std::ostream& operator<<(std::ostream& stream, const Sprt& sprt) {
+    std::lock_guard<std::mutex> lock(sprt.m_mutex);
+    stream << sprt.m_elo0 << ' ' << sprt.m_elo1 << ' ';
+    stream << sprt.m_alpha << ' ' << sprt.m_beta << ' ';
+    stream << sprt.m_wins << ' ' << sprt.m_losses << ' ';
+    stream << sprt.m_draws;
+    for (const auto pairs : sprt.m_pairs) {
+        stream << ' ' << pairs;
+    }
+    stream << '\n';
+    return stream;
+}
+
+std::istream& operator>>(std::istream& stream, Sprt& sprt) {
+    // Lines saved before the pair counts were added end
+    // after the draws.
+    auto line = std::string{};
+    std::getline(stream, line);
+    std::istringstream in(line);
+    std::lock_guard<std::mutex> lock(sprt.m_mutex);
+    in >> sprt.m_elo0 >> sprt.m_elo1 >> sprt.m_alpha >> sprt.m_beta;
+    in >> sprt.m_wins >> sprt.m_losses >> sprt.m_draws;
+    for (auto& pairs : sprt.m_pairs) {
+        pairs = 0;
+        in >> pairs;
+    }
+    return stream;
+}
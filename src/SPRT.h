@@ -0,0 +1,117 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Marco Calignano
+    originally taken from Cute Chess (http://github.com/cutechess)
+    Copyright (C) 2016 Ilari Pihlajisto
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPRT_H_INCLUDED
+#define SPRT_H_INCLUDED
+
+#include <array>
+#include <iosfwd>
+#include <mutex>
+#include <tuple>
+
+/*
+    Sequential Probability Ratio Test, used to stop a match as soon as
+    the Elo difference is known to be outside [elo0, elo1]. Both leelaz
+    and the validation tool use it, so it must not depend on Qt.
+    Instead of testing, it can also just estimate the Elo difference
+    over a fixed number of games, or until it is known within a margin.
+
+    Once results of game pairs are added, the test runs on the
+    pentanomial distribution of the pair scores instead, using the
+    normalized (logistic Elo) approximation of the log-likelihood ratio.
+    The two games of a pair are played from the same opening with colors
+    swapped, so much of the luck of the opening cancels out within a pair.
+
+    See http://en.wikipedia.org/wiki/Sequential_probability_ratio_test
+*/
+class Sprt {
+public:
+    enum Result {
+        Continue,   // Continue monitoring
+        AcceptH0,   // Accept null hypothesis H0
+        AcceptH1,   // Accept alternative hypothesis H1
+        Estimated   // Elo difference known within the margin
+    };
+
+    enum GameResult {
+        NoResult = 0,   // Game ended with no result
+        Win,            // First player won
+        Loss,           // First player lost
+        Draw,
+        NotEnded        // Game was interrupted
+    };
+
+    struct Status {
+        Result result;
+        double llr;     // Log-likelihood ratio
+        double lBound;  // Lower bound
+        double uBound;  // Upper bound
+    };
+
+    struct Elo {
+        double diff;    // Elo difference in favor of the first player
+        double error;   // 95% confidence margin
+    };
+
+    // elo0 is the Elo difference between the players for H0 and
+    // elo1 for H1. alpha and beta are the maximum probabilities
+    // for type I and type II errors outside [elo0, elo1].
+    void initialize(double elo0, double elo1, double alpha, double beta);
+    // Only estimate the Elo difference. status() is Estimated once the
+    // 95% confidence margin of get_elo() is below elo_margin. With a
+    // margin of 0 it stays Continue, for a fixed number of games.
+    void initialize_estimate(double elo_margin);
+    bool is_estimate() const { return m_estimate; }
+    Status status() const;
+    void add_game_result(GameResult result);
+    // Adds the results of a pair of games played from the same
+    // opening with colors swapped.
+    void add_pair_result(GameResult first, GameResult second);
+    // Returns the wins, draws and losses of the first player.
+    std::tuple<int, int, int> get_wdl() const;
+    // Returns the number of game pairs by the score of the first
+    // player in half points, from 0 (both lost) to 4 (both won).
+    std::array<int, 5> get_pentanomial() const;
+    Elo get_elo() const;
+
+    // One line with the bounds and the results so far.
+    friend std::ostream& operator<<(std::ostream& stream, const Sprt& sprt);
+    friend std::istream& operator>>(std::istream& stream, Sprt& sprt);
+
+private:
+    void count_game(GameResult result);
+    Status trinomial_status() const;
+    Status pentanomial_status() const;
+    Elo elo_estimate() const;
+
+    double m_elo0{0.0};
+    double m_elo1{0.0};
+    double m_alpha{0.0};
+    double m_beta{0.0};
+    bool m_estimate{false};
+    double m_elo_margin{0.0};
+    int m_wins{0};
+    int m_losses{0};
+    int m_draws{0};
+    std::array<int, 5> m_pairs{};
+    mutable std::mutex m_mutex;
+};
+
+#endif
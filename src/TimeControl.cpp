@@ -190,6 +190,25 @@ int TimeControl::max_time_for_move(int boardsize,
     return base_time + inc_time;
 }
 
+int TimeControl::max_time_extension(int boardsize,
+                                    int color, size_t movenum) const {
+    if (!can_accumulate_time(color)) {
+        return 0;
+    }
+    // Infinite time, nothing to extend.
+    if (m_byotime != 0 && m_byostones == 0 && m_byoperiods == 0) {
+        return 0;
+    }
+    // Borrow from the clock at most the base time again, and never more
+    // than a quarter of what is left for the following moves. Time saved
+    // on obvious moves shows up in the next base times, so the total
+    // stays within the clock.
+    const auto base_time = max_time_for_move(boardsize, color, movenum);
+    const auto spare_time =
+        m_remaining_time[color] - cfg_lagbuffer_cs - base_time;
+    return std::max(0, std::min(base_time, spare_time / 4));
+}
+
 void TimeControl::adjust_time(int color, int time, int stones) {
     m_remaining_time[color] = time;
     // From pachi: some GTP things send 0 0 at the end of main time
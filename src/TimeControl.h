@@ -36,6 +36,9 @@ public:
     void start(int color);
     void stop(int color);
     int max_time_for_move(int boardsize, int color, size_t movenum) const;
+    // Extra time the search may add to max_time_for_move for a critical
+    // position. Zero when time cannot be saved up for later moves.
+    int max_time_extension(int boardsize, int color, size_t movenum) const;
     void adjust_time(int color, int time, int stones);
     void display_times();
     void reset_clocks();
@@ -0,0 +1,137 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+#include "UCTChildList.h"
+
+constexpr size_t UCTChildList::FIRST_CHUNK;
+constexpr size_t UCTChildList::NUM_CHUNKS;
+
+std::unique_ptr<UCTChildList> UCTChildList::create(
+    const std::vector<Network::PolicyVertexPair>& nodelist) {
+
+    assert(!nodelist.empty() && nodelist.size() <= POTENTIAL_MOVES);
+    const auto ptr = ::operator new(bytes(nodelist.size()));
+    UCTNodePointer::increment_tree_size(bytes(nodelist.size()));
+    return std::unique_ptr<UCTChildList>(::new (ptr) UCTChildList(nodelist));
+}
+
+UCTChildList::UCTChildList(
+    const std::vector<Network::PolicyVertexPair>& nodelist)
+    : m_size(static_cast<std::uint16_t>(nodelist.size())) {
+
+    for (auto& chunk : m_chunks) {
+        chunk = nullptr;
+    }
+    for (size_t i = 0; i < nodelist.size(); i++) {
+        priors()[i] = nodelist[i].first;
+        moves()[i] = static_cast<packed_move_t>(nodelist[i].second + 1);
+    }
+}
+
+UCTChildList::~UCTChildList() {
+    const auto slots = m_slots.load();
+    auto start = size_t{0};
+    for (auto chunk = size_t{0}; start < slots; chunk++) {
+        const auto ptr = m_chunks[chunk].load();
+        const auto end = std::min(size_t{slots}, start + (FIRST_CHUNK << chunk));
+        for (auto i = start; i < end; i++) {
+            ptr[i - start].~UCTNodePointer();
+        }
+        ::operator delete(ptr);
+        start = end;
+    }
+    UCTNodePointer::decrement_tree_size(bytes(m_size));
+}
+
+void UCTChildList::operator delete(void * ptr) {
+    ::operator delete(ptr);
+}
+
+size_t UCTChildList::bytes(size_t size) {
+    return sizeof(UCTChildList)
+           + size * (sizeof(float) + sizeof(packed_move_t));
+}
+
+float * UCTChildList::priors() const {
+    return reinterpret_cast<float*>(
+        const_cast<UCTChildList*>(this) + 1);
+}
+
+UCTChildList::packed_move_t * UCTChildList::moves() const {
+    return reinterpret_cast<packed_move_t*>(priors() + m_size);
+}
+
+int UCTChildList::get_move(size_t index) const {
+    assert(index < m_size);
+    return int{moves()[index]} - 1;
+}
+
+float UCTChildList::get_policy(size_t index) const {
+    assert(index < m_size);
+    return priors()[index];
+}
+
+void UCTChildList::set_min_psa_ratio(float min_psa_ratio) {
+    const auto min_psa = get_policy(0) * min_psa_ratio;
+    auto visible = size_t{0};
+    while (visible < m_size && get_policy(visible) >= min_psa) {
+        visible++;
+    }
+    m_visible = static_cast<std::uint16_t>(visible);
+}
+
+UCTNodePointer& UCTChildList::slot(size_t index) const {
+    assert(index < slots());
+    auto start = size_t{0};
+    auto chunk = size_t{0};
+    while (index >= start + (FIRST_CHUNK << chunk)) {
+        start += FIRST_CHUNK << chunk;
+        chunk++;
+    }
+    return m_chunks[chunk].load()[index - start];
+}
+
+void UCTChildList::materialize(size_t count) {
+    count = std::min(count, size());
+    if (slots() >= count) {
+        return;
+    }
+    LOCK(m_mutex, lock);
+    auto start = size_t{0};
+    for (auto chunk = size_t{0}; start < count; chunk++) {
+        const auto end = std::min(size(), start + (FIRST_CHUNK << chunk));
+        if (slots() <= start) {
+            const auto ptr = static_cast<UCTNodePointer*>(
+                ::operator new(sizeof(UCTNodePointer) * (end - start)));
+            for (auto i = start; i < end; i++) {
+                ::new (&ptr[i - start]) UCTNodePointer(get_move(i),
+                                                       get_policy(i));
+            }
+            m_chunks[chunk] = ptr;
+            // Readers only go as far as m_slots, so set it last.
+            m_slots = static_cast<std::uint16_t>(end);
+        }
+        start = end;
+    }
+}
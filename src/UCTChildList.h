@@ -0,0 +1,116 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UCTCHILDLIST_H_INCLUDED
+#define UCTCHILDLIST_H_INCLUDED
+
+#include "config.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "FastBoard.h"
+#include "Network.h"
+#include "SMP.h"
+#include "UCTNodePointer.h"
+
+// Children of an expanded node that isn't the search root. The moves
+// and their priors are kept sorted by prior in one allocation, 5 bytes
+// per child. The priors stay fp32, so the search is the same as with a
+// UCTNodePointer per child. A slot is only created when the search goes
+// into a child. Unvisited children all get the same first play eval,
+// so the search always picks the one with the highest prior
+// first and the children with a slot are a prefix of the list.
+//
+// Slots live in chunks that double in size and never move, so they can
+// be read without a lock while other threads add chunks.
+class UCTChildList {
+public:
+    static constexpr size_t FIRST_CHUNK = 8;
+    static constexpr size_t NUM_CHUNKS =
+        POTENTIAL_MOVES <= FIRST_CHUNK * 31 ? 5 : 6;
+
+    // nodelist has to be sorted by policy, best first.
+    static std::unique_ptr<UCTChildList> create(
+        const std::vector<Network::PolicyVertexPair>& nodelist);
+    ~UCTChildList();
+    UCTChildList(const UCTChildList&) = delete;
+    UCTChildList& operator=(const UCTChildList&) = delete;
+    // The priors and moves are allocated along with the list.
+    static void operator delete(void * ptr);
+
+    size_t size() const { return m_size; }
+    int get_move(size_t index) const;
+    float get_policy(size_t index) const;
+
+    // Children with a prior below min_psa_ratio times the best one
+    // are hidden from the search.
+    void set_min_psa_ratio(float min_psa_ratio);
+    size_t visible() const { return m_visible.load(); }
+
+    // Number of children with a slot.
+    size_t slots() const { return m_slots.load(); }
+    UCTNodePointer& slot(size_t index) const;
+    // Creates the slots of at least the first count children.
+    void materialize(size_t count);
+
+    // Calls f on the slots of the first count children,
+    // count has to be at most slots().
+    template <typename F>
+    void for_each_slot(size_t count, F&& f) const {
+        auto start = size_t{0};
+        for (auto chunk = size_t{0}; start < count; chunk++) {
+            const auto slots = m_chunks[chunk].load();
+            const auto end = std::min(count, start + (FIRST_CHUNK << chunk));
+            for (auto i = start; i < end; i++) {
+                f(slots[i - start]);
+            }
+            start = end;
+        }
+    }
+
+private:
+    // Moves are stored off by one, so a pass fits in a byte
+    // on the board sizes that allow it.
+    using packed_move_t = std::conditional<
+        FastBoard::NUM_VERTICES < 255, std::uint8_t, std::uint16_t>::type;
+
+    explicit UCTChildList(
+        const std::vector<Network::PolicyVertexPair>& nodelist);
+    static size_t bytes(size_t size);
+    float * priors() const;
+    packed_move_t * moves() const;
+
+    std::array<std::atomic<UCTNodePointer*>, NUM_CHUNKS> m_chunks;
+    std::atomic<std::uint16_t> m_slots{0};
+    std::atomic<std::uint16_t> m_visible{0};
+    std::uint16_t m_size;
+    SMP::Mutex m_mutex;
+};
+
+static_assert(UCTChildList::FIRST_CHUNK
+              * ((size_t{1} << UCTChildList::NUM_CHUNKS) - 1)
+              >= POTENTIAL_MOVES, "Not enough child slot chunks");
+
+#endif
@@ -42,7 +42,14 @@
 
 using namespace Utils;
 
-UCTNode::UCTNode(int vertex, float policy) : m_move(vertex), m_policy(policy) {
+UCTNode::UCTNode(int vertex, float policy) : m_policy(policy), m_move(vertex) {
+}
+
+UCTNode::StrengthState& UCTNode::strength_state() {
+    if (!m_strength_state) {
+        m_strength_state = std::make_unique<StrengthState>();
+    }
+    return *m_strength_state;
 }
 
 bool UCTNode::first_visit() const {
@@ -86,8 +93,8 @@ void UCTNode::get_static_policy(Network & network,
         }
     }
 
-    this->initial_node_list = nodelist;
-    printf("git static policy from network! \n");
+    strength_state().initial_node_list = nodelist;
+    myprintf("git static policy from network! \n");
 
 }
 
@@ -158,6 +165,50 @@ bool UCTNode::create_children(Network & network,
     return true;
 }
 
+bool UCTNode::reevaluate(Network & network, GameState& state,
+                         float& correction) {
+    if (!m_fast_eval.exchange(false)) {
+        return false;
+    }
+    const auto raw_netlist = network.get_output(
+        &state, Network::Ensemble::RANDOM_SYMMETRY);
+
+    auto net_eval = raw_netlist.winrate;
+    if (state.board.white_to_move()) {
+        net_eval = 1.0f - net_eval;
+    }
+    correction = net_eval - m_net_eval;
+    m_net_eval = net_eval;
+    accumulate_eval(correction);
+
+    // With pruned children the rest would be linked in policy order
+    // later, so the priors can only be swapped when all are here.
+    if (m_min_psa_ratio_children > 0.0f) {
+        return true;
+    }
+    auto policy_of = [&](int move) {
+        if (move == FastBoard::PASS) {
+            return raw_netlist.policy_pass;
+        }
+        const auto xy = state.board.get_xy(move);
+        return raw_netlist.policy[xy.first + xy.second * BOARD_SIZE];
+    };
+    // The new priors don't keep the order of the compact list.
+    if (m_child_list) {
+        m_child_list->materialize(m_child_list->size());
+    }
+    auto policy_sum = 0.0f;
+    for_each_child([&](const UCTNodePointer& child) {
+        policy_sum += policy_of(child.get_move());
+    });
+    if (policy_sum > std::numeric_limits<float>::min()) {
+        for_each_child([&](UCTNodePointer& child) {
+            child.set_policy(policy_of(child.get_move()) / policy_sum);
+        });
+    }
+    return true;
+}
+
 void UCTNode::link_nodelist(std::atomic<int>& nodecount,
                             std::vector<Network::PolicyVertexPair>& nodelist,
                             float min_psa_ratio) {
@@ -170,6 +221,21 @@ void UCTNode::link_nodelist(std::atomic<int>& nodecount,
     // Use best to worst order, so highest go first
     std::stable_sort(rbegin(nodelist), rend(nodelist));
 
+    // Only the root has children in m_children, the compact list
+    // has all of them and hides the pruned ones.
+    if (m_children.empty()) {
+        if (!m_child_list) {
+            m_child_list = UCTChildList::create(nodelist);
+        }
+        const auto old_visible = m_child_list->visible();
+        m_child_list->set_min_psa_ratio(min_psa_ratio);
+        nodecount += int(m_child_list->visible() - old_visible);
+        const auto skipped_children =
+            m_child_list->visible() < m_child_list->size();
+        m_min_psa_ratio_children = skipped_children ? min_psa_ratio : 0.0f;
+        return;
+    }
+
     const auto max_psa = nodelist[0].first;
     const auto old_min_psa = max_psa * m_min_psa_ratio_children;
     const auto new_min_psa = max_psa * min_psa_ratio;
@@ -197,9 +263,64 @@ void UCTNode::link_nodelist(std::atomic<int>& nodecount,
 }
 
 std::vector<UCTNodePointer>& UCTNode::get_children() {
+    assert(!m_child_list);
     return m_children;
 }
 
+size_t UCTNode::get_num_children() const {
+    if (m_child_list) {
+        return m_child_list->visible();
+    }
+    return m_children.size();
+}
+
+std::vector<int> UCTNode::get_child_moves() const {
+    auto moves = std::vector<int>{};
+    if (m_child_list) {
+        for (size_t i = 0; i < m_child_list->visible(); i++) {
+            moves.emplace_back(m_child_list->get_move(i));
+        }
+    } else {
+        for (const auto& child : m_children) {
+            moves.emplace_back(child.get_move());
+        }
+    }
+    return moves;
+}
+
+size_t UCTNode::get_num_slots() const {
+    if (m_child_list) {
+        return std::min(m_child_list->slots(), m_child_list->visible());
+    }
+    return m_children.size();
+}
+
+bool UCTNode::has_unslotted_child(size_t slots) const {
+    return m_child_list && slots < m_child_list->visible();
+}
+
+UCTNodePointer& UCTNode::slot_child(size_t index) {
+    m_child_list->materialize(index + 1);
+    return m_child_list->slot(index);
+}
+
+UCTNodePointer* UCTNode::find_slot(int move) {
+    if (m_child_list) {
+        for (size_t i = 0; i < m_child_list->visible(); i++) {
+            if (m_child_list->get_move(i) == move) {
+                return &slot_child(i);
+            }
+        }
+        return nullptr;
+    }
+    for (auto& child : m_children) {
+        if (child.get_move() == move) {
+            return &child;
+        }
+    }
+    return nullptr;
+}
+
 
 float UCTNode::get_static_sp() const {
     return m_static_sp;
@@ -209,12 +330,12 @@ int UCTNode::get_move() const {
     return m_move;
 }
 
-void UCTNode::virtual_loss() {
-    m_virtual_loss += VIRTUAL_LOSS_COUNT;
+void UCTNode::virtual_loss(int count) {
+    m_virtual_loss += count;
 }
 
-void UCTNode::virtual_loss_undo() {
-    m_virtual_loss -= VIRTUAL_LOSS_COUNT;
+void UCTNode::virtual_loss_undo(int count) {
+    m_virtual_loss -= count;
 }
 
 void UCTNode::update(float eval) {
@@ -226,6 +347,10 @@ bool UCTNode::has_children() const {
     return m_min_psa_ratio_children <= 1.0f;
 }
 
+bool UCTNode::expanding() const {
+    return m_expand_state.load() == ExpandState::EXPANDING;
+}
+
 bool UCTNode::expandable(const float min_psa_ratio) const {
 #ifndef NDEBUG
     if (m_min_psa_ratio_children == 0.0f) {
@@ -288,17 +413,20 @@ void UCTNode::accumulate_eval(float eval) {
 UCTNode* UCTNode::uct_select_child(int color, bool is_root) {
     wait_expanded();
 
+    // Other threads can add slots, look at the same children throughout.
+    const auto slots = get_num_slots();
+
     // Count parentvisits manually to avoid issues with transpositions.
     auto total_visited_policy = 0.0f;
     auto parentvisits =size_t{0};
-    for (const auto& child : m_children) {
+    for_each_slot(slots, [&](const UCTNodePointer& child) {
         if (child.valid()) {
             parentvisits += child.get_visits();
             if (child.get_visits() > 0) {
                 total_visited_policy += child.get_policy();
             }
         }
-    }
+    });
 
     const auto numerator = std::sqrt(double(parentvisits));
     // todo how it works
@@ -309,9 +437,9 @@ UCTNode* UCTNode::uct_select_child(int color, bool is_root) {
     auto best = static_cast<UCTNodePointer*>(nullptr);
     auto best_value = std::numeric_limits<double>::lowest();
 
-    for (auto& child : m_children) {
+    for_each_slot(slots, [&](UCTNodePointer& child) {
         if (!child.active()) {
-            continue;
+            return;
         }
 
         auto winrate = fpu_eval;
@@ -332,6 +460,14 @@ UCTNode* UCTNode::uct_select_child(int color, bool is_root) {
             best_value = value;
             best = &child;
         }
+    });
+
+    if (has_unslotted_child(slots)) {
+        const auto psa = m_child_list->get_policy(slots);
+        const auto value = fpu_eval + cfg_puct * psa * numerator;
+        if (value > best_value) {
+            best = &slot_child(slots);
+        }
     }
 
     assert(best != nullptr);
@@ -458,7 +594,7 @@ std::string UCTNode::transferMove(int move) const {
 
 std::string UCTNode::print_candidates(int color,float selectedWinrate){
 
-    printf("begin to show candidates moves \n");
+    myprintf("begin to show candidates moves \n");
 
     std::string candidatesString = "LB";
 
@@ -500,14 +636,15 @@ std::string UCTNode::print_candidates(int color,float selectedWinrate){
 
     candidatesString+="]";
 
-    printf("%s,",candidatesString.c_str());
+    myprintf("%s,",candidatesString.c_str());
 
-    printf("show end!");
+    myprintf("show end!\n");
 
     return candidatesString;
 }
 
-void UCTNode::usingStrengthControl(int color,int lastMove){
+void UCTNode::usingStrengthControl(int color,int lastMove,
+                                   const StrengthParams& params){
 
             //case 1: the winrate dif between first and second move is too high(10%),we just use the first move;
     //case 2: the winrate of first is too low, we just select the first move;
@@ -516,10 +653,11 @@ void UCTNode::usingStrengthControl(int color,int lastMove){
         // (1) select move with the best select policy
         // (2) play the best move
 
-    printf("using strength control \n");
+    myprintf("using strength control \n");
 
     int index = 0;
-    case_three = false;
+    auto& strength = strength_state();
+    strength.case_three = false;
 
     float first = 0,second = 0;
 
@@ -536,7 +674,7 @@ void UCTNode::usingStrengthControl(int color,int lastMove){
 
         index ++;
 
-        for (const auto& initial_node: this->initial_node_list){
+        for (const auto& initial_node: strength.initial_node_list){
             if(initial_node.second==child.get_move()){
                 child->m_static_sp = initial_node.first;
             }
@@ -544,38 +682,41 @@ void UCTNode::usingStrengthControl(int color,int lastMove){
 
     }
 
-    printf("the first wr: %f, the second wr: %f",first,second);
+    myprintf("the first wr: %f, the second wr: %f\n",first,second);
 
-    if(accord_case_one(first,second)){
+    if(accord_case_one(first,second,params)){
         // do nothing
-        printf("accord with case one \n");
-    }else if(accord_case_two(first)){
+        myprintf("accord with case one \n");
+    }else if(accord_case_two(first,params)){
         //do nothing
-        printf("accord with case two \n");
-    }else if(first>=t_min && first<=t_max){
+        myprintf("accord with case two \n");
+    }else if(first>=params.t_min && first<=params.t_max){
         // do nothing
 
-        accord_case_three(color,first-t_dif);
-        printf("accord with case three \n");
-        printf("case three move is %d \n",case_three_move);
+        accord_case_three(color,first-params.t_dif());
+        myprintf("accord with case three \n");
+        myprintf("case three move is %d \n",strength.case_three_move);
 
     }else{
-        accord_case_three_one(color,lastMove);
+        accord_case_three_one(color,lastMove,params);
     }
 
 }
 
-bool UCTNode::accord_case_one(float first,float second){
-    return first-second>=t_uniq;
+bool UCTNode::accord_case_one(float first,float second,
+                              const StrengthParams& params){
+    return first-second>=params.t_uniq();
 }
 
-bool UCTNode::accord_case_two(float first){
-    return first<=t_min;
+bool UCTNode::accord_case_two(float first,const StrengthParams& params){
+    return first<=params.t_min;
 }
 
 bool UCTNode::accord_case_three(int color,float threshold){
 
-    case_three = true;
+    auto& strength = strength_state();
+
+    strength.case_three = true;
 
     float _sp = 0;
 
@@ -584,8 +725,8 @@ bool UCTNode::accord_case_three(int color,float threshold){
         if (child.get_eval(color)>=threshold) {
             if (child.get_static_sp() > _sp) {
                 _sp = child.get_static_sp();
-                case_three_move = child.get_move();
-                case_three_winrate = child.get_eval(color);
+                strength.case_three_move = child.get_move();
+                strength.case_three_winrate = child.get_eval(color);
             }
         }
     }
@@ -593,7 +734,10 @@ bool UCTNode::accord_case_three(int color,float threshold){
     return false;
 }
 
-bool UCTNode::accord_case_three_one(int color,int lastmove){
+bool UCTNode::accord_case_three_one(int color,int lastmove,
+                                    const StrengthParams& params){
+
+    auto& strength = strength_state();
 
     float firstMoveRate;
     float allowedProb1,allowedProb2,allowedProb3,allowedProb4;
@@ -603,13 +747,13 @@ bool UCTNode::accord_case_three_one(int color,int lastmove){
 
     firstMoveRate = get_first_child()->get_eval(color);
 
-    allowedProb1 = firstMoveRate-(float)0.03*c_param;
-    allowedProb2 = firstMoveRate-(float)0.04*c_param;
-    allowedProb3 = firstMoveRate-(float)0.06*c_param;
-    allowedProb4 = firstMoveRate-(float)0.08*c_param;
+    allowedProb1 = firstMoveRate-(float)0.03*params.c_param;
+    allowedProb2 = firstMoveRate-(float)0.04*params.c_param;
+    allowedProb3 = firstMoveRate-(float)0.06*params.c_param;
+    allowedProb4 = firstMoveRate-(float)0.08*params.c_param;
 
-    case_three_move = get_first_child()->get_move();
-    case_three_winrate = get_first_child()->get_eval(color);
+    strength.case_three_move = get_first_child()->get_move();
+    strength.case_three_winrate = get_first_child()->get_eval(color);
     float _evaluation_rate = 0 ;
 
     for (const auto& child : get_children()) {
@@ -624,11 +768,11 @@ bool UCTNode::accord_case_three_one(int color,int lastmove){
 
             if (prob >= allowedProb4 && prob <= allowedProb3 && policy >= allowedPolicy4) {
 
-                printf("accord with case 3-4 \n");
+                myprintf("accord with case 3-4 \n");
 
-                printf("policy is: %f,allowedPolicy is:%f.", policy, allowedPolicy4);
+                myprintf("policy is: %f,allowedPolicy is:%f.\n", policy, allowedPolicy4);
 
-                case_three = true;
+                strength.case_three = true;
 
                 //
                 //            float dis = calulate_dis_between_moves(lastmove,_move);
@@ -640,20 +784,20 @@ bool UCTNode::accord_case_three_one(int color,int lastmove){
                 //                _evaluation_rate = evaluation_rate;
                 //            }
 
-                if (case_three_winrate > prob) {
-                    case_three_move = _move;
-                    case_three_winrate = prob;
+                if (strength.case_three_winrate > prob) {
+                    strength.case_three_move = _move;
+                    strength.case_three_winrate = prob;
                 }
 
             }
 
             if (prob >= allowedProb3 && prob <= allowedProb2 && policy >= allowedPolicy3) {
 
-                printf("accord with case 3-3 \n");
+                myprintf("accord with case 3-3 \n");
 
-                printf("policy is: %f,allowedPolicy is:%f.", policy, allowedPolicy3);
+                myprintf("policy is: %f,allowedPolicy is:%f.\n", policy, allowedPolicy3);
 
-                case_three = true;
+                strength.case_three = true;
 
                 //            float dis = calulate_dis_between_moves(lastmove,_move);
                 //            float evaluation_rate = (1-dis)*policy;
@@ -663,20 +807,20 @@ bool UCTNode::accord_case_three_one(int color,int lastmove){
                 //                _evaluation_rate = evaluation_rate;
                 //            }
 
-                if (case_three_winrate > prob) {
-                    case_three_move = _move;
-                    case_three_winrate = prob;
+                if (strength.case_three_winrate > prob) {
+                    strength.case_three_move = _move;
+                    strength.case_three_winrate = prob;
                 }
             }
 
 
             if (prob >= allowedProb2 && prob <= allowedProb1 && policy >= allowedPolicy2) {
 
-                printf("accord with case 3-2 \n");
+                myprintf("accord with case 3-2 \n");
 
-                printf("policy is: %f,allowedPolicy is:%f.", policy, allowedPolicy2);
+                myprintf("policy is: %f,allowedPolicy is:%f.\n", policy, allowedPolicy2);
 
-                case_three = true;
+                strength.case_three = true;
 
                 //            float dis = calulate_dis_between_moves(lastmove,_move);
                 //            float evaluation_rate = (1-dis)*policy;
@@ -686,19 +830,19 @@ bool UCTNode::accord_case_three_one(int color,int lastmove){
                 //                _evaluation_rate = evaluation_rate;
                 //            }
 
-                if (case_three_winrate > prob) {
-                    case_three_move = _move;
-                    case_three_winrate = prob;
+                if (strength.case_three_winrate > prob) {
+                    strength.case_three_move = _move;
+                    strength.case_three_winrate = prob;
                 }
             }
 
             if (prob >= allowedProb1 && policy > allowedPolicy1) {
 
-                printf("accord with case 3-1 \n");
+                myprintf("accord with case 3-1 \n");
 
-                printf("policy is: %f,allowedPolicy is:%f.", policy, allowedPolicy1);
+                myprintf("policy is: %f,allowedPolicy is:%f.\n", policy, allowedPolicy1);
 
-                case_three = true;
+                strength.case_three = true;
 
                 //            float dis = calulate_dis_between_moves(lastmove,_move);
                 //            float evaluation_rate = (1-dis)*policy;
@@ -708,9 +852,9 @@ bool UCTNode::accord_case_three_one(int color,int lastmove){
                 //                _evaluation_rate = evaluation_rate;
                 //            }
 
-                if (case_three_winrate > prob) {
-                    case_three_move = _move;
-                    case_three_winrate = prob;
+                if (strength.case_three_winrate > prob) {
+                    strength.case_three_move = _move;
+                    strength.case_three_winrate = prob;
                 }
 
             }
@@ -720,25 +864,33 @@ bool UCTNode::accord_case_three_one(int color,int lastmove){
 }
 
 bool UCTNode::get_case_three_flag(){
-    return case_three;
+    return m_strength_state && m_strength_state->case_three;
 }
 
 int UCTNode::get_case_three_move(){
-    return case_three_move;
+    return strength_state().case_three_move;
 }
 
 float UCTNode::get_case_three_winrate(){
-    return case_three_winrate;
+    return strength_state().case_three_winrate;
 }
 
 
 UCTNode& UCTNode::get_best_root_child(int color) {
     wait_expanded();
 
-    assert(!m_children.empty());
-
-    auto ret = std::max_element(begin(m_children), end(m_children),
-                                NodeComp(color));
+    const auto slots = get_num_slots();
+    auto ret = static_cast<UCTNodePointer*>(nullptr);
+    for_each_slot(slots, [&](UCTNodePointer& child) {
+        if (!ret || NodeComp(color)(*ret, child)) {
+            ret = &child;
+        }
+    });
+    if (has_unslotted_child(slots)
+        && (!ret || ret->get_policy() < m_child_list->get_policy(slots))) {
+        ret = &slot_child(slots);
+    }
+    assert(ret != nullptr);
     ret->inflate();
 
     return *(ret->get());
@@ -746,15 +898,15 @@ UCTNode& UCTNode::get_best_root_child(int color) {
 
 size_t UCTNode::count_nodes_and_clear_expand_state() {
     auto nodecount = size_t{0};
-    nodecount += m_children.size();
+    nodecount += get_num_children();
     if (expandable()) {
         m_expand_state = ExpandState::INITIAL;
     }
-    for (auto& child : m_children) {
+    for_each_child([&](UCTNodePointer& child) {
         if (child.is_inflated()) {
             nodecount += child->count_nodes_and_clear_expand_state();
         }
-    }
+    });
     return nodecount;
 }
 
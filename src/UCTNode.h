@@ -30,13 +30,24 @@
 #include "GameState.h"
 #include "Network.h"
 #include "SMP.h"
+#include "UCTChildList.h"
 #include "UCTNodePointer.h"
 
+// Thresholds used by UCTNode::usingStrengthControl to pick a weaker
+// move. c_param scales how far from the best winrate we may go.
+struct StrengthParams {
+    float c_param{0.8f};
+    float t_max{0.60f};
+    float t_min{0.40f};
+    float t_dif() const { return 0.03f * c_param; }
+    float t_uniq() const { return 0.08f * c_param; } // the gap
+};
+
 class UCTNode {
 public:
     // When we visit a node, add this amount of virtual losses
     // to it to encourage other CPUs to explore other parts of the
-    // search tree.
+    // search tree. The search may tune it, this is the starting value.
     static constexpr auto VIRTUAL_LOSS_COUNT = 3;
     // Defined in UCTNode.cpp
     explicit UCTNode(int vertex, float policy);
@@ -44,21 +55,43 @@ public:
     ~UCTNode() = default;
 
     void get_static_policy(Network & network,GameState& state);
+    // The eval and priors of this node come from a cheaper network.
+    void set_fast_eval() { m_fast_eval = true; }
+    bool fast_eval() const { return m_fast_eval; }
+    // Replaces the eval (and the priors of the children, if none were
+    // pruned) with those of network. correction is set to the change
+    // of the eval, the ancestors of this node have to add it. Returns
+    // false if another thread did this already.
+    bool reevaluate(Network & network, GameState& state, float& correction);
     bool create_children(Network & network,
                          std::atomic<int>& nodecount,
                          GameState& state, float& eval,
                          float min_psa_ratio = 0.0f);
 
+    // Only for the root, see inflate_all_children.
     std::vector<UCTNodePointer>& get_children();
+    // Calls f on the children that have a UCTNodePointer, which are
+    // all that have visits.
+    template <typename F>
+    void for_each_child(F&& f) {
+        for_each_slot(get_num_slots(), f);
+    }
+    size_t get_num_children() const;
+    // The moves of the children, best prior first unless the root
+    // has been sorted.
+    std::vector<int> get_child_moves() const;
     void sort_children(int color);
     std::string transforMoveForSGF(int move) const;
     std::string transferMove(int move) const;
     std::string print_candidates(int color,float selectedWinrate);
-    void usingStrengthControl(int color,int lastmove);
-    bool accord_case_one(float first,float second);
-    bool accord_case_two(float first);
+    void usingStrengthControl(int color,int lastmove,
+                              const StrengthParams& params);
+    bool accord_case_one(float first,float second,
+                         const StrengthParams& params);
+    bool accord_case_two(float first,const StrengthParams& params);
     bool accord_case_three(int color,float _dif);
-    bool accord_case_three_one(int color,int lastmove);
+    bool accord_case_three_one(int color,int lastmove,
+                               const StrengthParams& params);
     bool get_case_three_flag();
     int get_case_three_move();
     float get_case_three_winrate();
@@ -68,12 +101,9 @@ public:
     size_t count_nodes_and_clear_expand_state();
     bool first_visit() const;
     bool has_children() const;
+    // Another thread is creating the children of this node.
+    bool expanding() const;
     bool expandable(const float min_psa_ratio = 0.0f) const;
-    const float c_param = 0.8;
-    float t_dif = 0.03*c_param;
-    float t_max = 0.60;
-    float t_min = 0.40;
-    float t_uniq = 0.08*c_param;// the gap
     void invalidate();
     void set_active(const bool active);
     bool valid() const;
@@ -86,20 +116,39 @@ public:
     float get_eval(int tomove) const;
     float get_raw_eval(int tomove, int virtual_loss = 0) const;
     float get_net_eval(int tomove) const;
-    void virtual_loss();
-    void virtual_loss_undo();
+    void virtual_loss(int count);
+    void virtual_loss_undo(int count);
     void update(float eval);
+    // Adds to the evals without counting a visit.
+    void accumulate_eval(float eval);
 
     // Defined in UCTNodeRoot.cpp, only to be called on m_root in UCTSearch
     void randomize_first_proportionally();
     void prepare_root_node(Network & network, int color,
                            std::atomic<int>& nodecount,
                            GameState& state);
+    // Merges the children that are equivalent under a symmetry of
+    // the position (and of the history the network sees) into one
+    // child, so the search doesn't split its visits over them.
+    // Returns the merged moves, the one that was kept first.
+    std::vector<std::vector<int>> merge_symmetric_children(
+        const GameState& state);
+    // Splits the merged children up again, sharing out their visits.
+    void unmerge_symmetric_children(
+        const std::vector<std::vector<int>>& merged);
 
     UCTNode* get_first_child() const;
     float calulate_dis_between_moves(int move1,int move2) const ;
     UCTNode* get_nopass_child(FastState& state) const;
+    // Takes the subtree of move out of this node. An unexpanded child
+    // with the same policy is left in its place and the visits of the
+    // subtree are taken off this node, so it remains a complete (if
+    // shallower) tree.
     std::unique_ptr<UCTNode> find_child(const int move);
+    // Puts a subtree taken by find_child back. Fails if the child has
+    // been expanded again meanwhile.
+    bool attach_child(std::unique_ptr<UCTNode>& node);
+    // Moves the children into m_children and inflates them.
     void inflate_all_children();
 
     void clear_expand_state();
@@ -113,30 +162,44 @@ private:
                        std::vector<Network::PolicyVertexPair>& nodelist,
                        float min_psa_ratio);
     double get_blackevals() const;
-    void accumulate_eval(float eval);
+    // Children with a UCTNodePointer are the first ones of
+    // m_child_list, or all of m_children.
+    size_t get_num_slots() const;
+    template <typename F>
+    void for_each_slot(size_t count, F&& f) {
+        if (m_child_list) {
+            m_child_list->for_each_slot(count, f);
+            return;
+        }
+        for (auto i = size_t{0}; i < count; i++) {
+            f(m_children[i]);
+        }
+    }
+    // The children of m_child_list from get_num_slots() on are
+    // unvisited and the first has the highest prior of them.
+    bool has_unslotted_child(size_t slots) const;
+    UCTNodePointer& slot_child(size_t index);
+    UCTNodePointer* find_slot(int move);
     void kill_superkos(const KoState& state);
     void dirichlet_noise(float epsilon, float alpha);
 
+    // Strength-control bookkeeping. Only the root of a search needs
+    // it, so it is allocated on first use instead of living in every
+    // node of the tree.
+    struct StrengthState {
+        std::vector<Network::PolicyVertexPair> initial_node_list;
+        bool case_three{false};
+        int case_three_move{FastBoard::PASS};
+        float case_three_winrate{0.0f};
+    };
+    StrengthState& strength_state();
+
     // Note : This class is very size-sensitive as we are going to create
     // tens of millions of instances of these.  Please put extra caution
     // if you want to add/remove/reorder any variables here.
+    // Members are ordered by size to avoid padding.
 
-    // Move
-    std::int16_t m_move;
-    std::float_t m_static_sp{0.0f};
-    // UCT
-    std::atomic<std::int16_t> m_virtual_loss{0};
-    std::atomic<int> m_visits{0};
-    // UCT eval
-    float m_policy;
-    // Original net eval for this node (not children).
-    float m_net_eval{0.0f};
-    std::atomic<double> m_blackevals{0.0};
-    std::atomic<Status> m_status{ACTIVE};
-    std::vector<Network::PolicyVertexPair> initial_node_list;
-
-
-    // m_expand_state acts as the lock for m_children.
+    // m_expand_state acts as the lock for m_children and m_child_list.
     // see manipulation methods below for possible state transition
     enum class ExpandState : std::uint8_t {
         // initial state, no children
@@ -151,15 +214,29 @@ private:
         // context, until node is destroyed.
         EXPANDED,
     };
-    std::atomic<ExpandState> m_expand_state{ExpandState::INITIAL};
 
-    // Tree data
-    std::atomic<float> m_min_psa_ratio_children{2.0f};
+    // UCT eval
+    std::atomic<double> m_blackevals{0.0};
+    // Tree data. The root keeps its children in m_children, which
+    // can be sorted and pruned, the other nodes in m_child_list.
     std::vector<UCTNodePointer> m_children;
-    bool case_three;
-    int case_three_move;
-    int case_three_visit;
-    float case_three_winrate;
+    std::unique_ptr<UCTChildList> m_child_list;
+    std::unique_ptr<StrengthState> m_strength_state;
+    // UCT
+    std::atomic<int> m_visits{0};
+    // Re-evaluated nodes swap in new priors during the search.
+    std::atomic<float> m_policy;
+    // Original net eval for this node (not children).
+    float m_net_eval{0.0f};
+    std::float_t m_static_sp{0.0f};
+    std::atomic<float> m_min_psa_ratio_children{2.0f};
+    // Move
+    std::int16_t m_move;
+    std::atomic<std::int16_t> m_virtual_loss{0};
+    std::atomic<Status> m_status{ACTIVE};
+    std::atomic<ExpandState> m_expand_state{ExpandState::INITIAL};
+    std::atomic<bool> m_fast_eval{false};
+
     //  m_expand_state manipulation methods
     // INITIAL -> EXPANDING
     // Return false if current state is not INITIAL
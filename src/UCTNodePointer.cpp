@@ -88,6 +88,17 @@ UCTNode * UCTNodePointer::release() {
     return read_ptr(v);
 }
 
+void UCTNodePointer::attach(std::unique_ptr<UCTNode> node) {
+    auto v2 = reinterpret_cast<std::uint64_t>(node.release()) | POINTER;
+    auto v = std::atomic_exchange(&m_data, v2);
+#ifdef NDEBUG
+    (void)v;
+#else
+    assert(!is_inflated(v));
+#endif
+    increment_tree_size(sizeof(UCTNode));
+}
+
 void UCTNodePointer::inflate() const {
     while (true) {
         auto v = m_data.load();
@@ -126,6 +137,23 @@ float UCTNodePointer::get_policy() const {
     return read_policy(v);
 }
 
+void UCTNodePointer::set_policy(float policy) {
+    std::uint32_t i_policy;
+    std::memcpy(&i_policy, &policy, sizeof(i_policy));
+    while (true) {
+        auto v = m_data.load();
+        if (is_inflated(v)) {
+            read_ptr(v)->set_policy(policy);
+            return;
+        }
+        auto v2 = (v & 0xFFFFFFFFULL)
+                | (static_cast<std::uint64_t>(i_policy) << 32);
+        if (m_data.compare_exchange_strong(v, v2)) {
+            return;
+        }
+    }
+}
+
 bool UCTNodePointer::active() const {
     auto v = m_data.load();
     if (is_inflated(v)) return read_ptr(v)->active();
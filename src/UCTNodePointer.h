@@ -43,6 +43,8 @@ class UCTNode;
 // the instanced is 'moved from'.
 
 class UCTNodePointer {
+    // Accounts for its own allocations in the tree size.
+    friend class UCTChildList;
 private:
     static constexpr std::uint64_t INVALID = 2;
     static constexpr std::uint64_t POINTER = 1;
@@ -110,6 +112,8 @@ public:
     }
     UCTNodePointer& operator=(UCTNodePointer&& n);
     UCTNode * release();
+    // Takes over node in place of an uninflated pointer.
+    void attach(std::unique_ptr<UCTNode> node);
 
     // construct UCTNode instance from the vertex/policy pair
     void inflate() const;
@@ -119,6 +123,7 @@ public:
     bool valid() const;
     int get_visits() const;
     float get_policy() const;
+    void set_policy(float policy);
     bool active() const;
     int get_move() const;
     // this can only be called if it is an inflated pointer
@@ -59,7 +59,7 @@ float UCTNode::calulate_dis_between_moves(int move1,int move2) const {
     const auto dis = (float)pow((move1_x-move2_x)*(move1_x-move2_x)+(move1_y-move2_y)*(move1_y-move2_y),0.5f);
     const  auto a = (float)(dis/12*0.4142);
 
-    printf("the dis_rate is %f \n",a);
+    Utils::myprintf("the dis_rate is %f \n",a);
 
     return a;
 }
@@ -176,35 +176,163 @@ UCTNode* UCTNode::get_nopass_child(FastState& state) const {
 
 // Used to find new root in UCTSearch.
 std::unique_ptr<UCTNode> UCTNode::find_child(const int move) {
-    for (auto& child : m_children) {
-        if (child.get_move() == move) {
-            // no guarantee that this is a non-inflated node
-            child.inflate();
-            return std::unique_ptr<UCTNode>(child.release());
-        }
+    // Cached trees are walked down through nodes that never were a root.
+    const auto child = find_slot(move);
+    if (!child) {
+        // Can happen if we resigned or children are not expanded
+        return nullptr;
     }
+    const auto policy = child->get_policy();
+    // no guarantee that this is a non-inflated node
+    child->inflate();
+    auto node = std::unique_ptr<UCTNode>(child->release());
+    *child = UCTNodePointer(move, policy);
+    m_visits -= node->get_visits();
+    m_blackevals = get_blackevals() - node->get_blackevals();
+    return node;
+}
 
-    // Can happen if we resigned or children are not expanded
-    return nullptr;
+bool UCTNode::attach_child(std::unique_ptr<UCTNode>& node) {
+    const auto child = find_slot(node->get_move());
+    if (!child || child->is_inflated()) {
+        return false;
+    }
+    m_visits += node->get_visits();
+    m_blackevals = get_blackevals() + node->get_blackevals();
+    child->attach(std::move(node));
+    return true;
 }
 
 void UCTNode::inflate_all_children() {
+    if (m_child_list) {
+        const auto count = m_child_list->visible();
+        m_child_list->materialize(count);
+        m_children.reserve(count);
+        for_each_slot(count, [this](UCTNodePointer& child) {
+            m_children.emplace_back(std::move(child));
+        });
+        m_child_list.reset();
+    }
     for (const auto& node : get_children()) {
         node.inflate();
     }
 }
 
+std::vector<std::vector<int>> UCTNode::merge_symmetric_children(
+    const GameState& state) {
+
+    auto merged = std::vector<std::vector<int>>{};
+    auto symmetries = std::vector<int>{};
+    for (auto s = 1; s < Network::NUM_SYMMETRIES; s++) {
+        symmetries.emplace_back(s);
+    }
+    auto history = std::make_unique<GameState>(state);
+    for (auto i = 0; i < Network::INPUT_MOVES; i++) {
+        const auto hash = history->get_symmetry_hash(0);
+        symmetries.erase(
+            std::remove_if(begin(symmetries), end(symmetries),
+                [&](int s) { return history->get_symmetry_hash(s) != hash; }),
+            end(symmetries));
+        if (symmetries.empty() || !history->undo_move()) {
+            break;
+        }
+    }
+    if (symmetries.empty()) {
+        return merged;
+    }
+
+    auto child_with = [this](int move) {
+        return std::find_if(begin(m_children), end(m_children),
+            [move](const UCTNodePointer& child) {
+                return child.get_move() == move;
+            });
+    };
+    auto removed = std::vector<bool>(m_children.size(), false);
+    for (size_t i = 0; i < m_children.size(); i++) {
+        const auto move = m_children[i].get_move();
+        if (removed[i] || move == FastBoard::PASS) {
+            continue;
+        }
+        auto equivalent = std::vector<int>{move};
+        auto policy = m_children[i].get_policy();
+        for (const auto s : symmetries) {
+            const auto xy = Network::get_symmetry(state.board.get_xy(move), s);
+            const auto other = state.board.get_vertex(xy.first, xy.second);
+            const auto it = child_with(other);
+            const auto j = size_t(std::distance(begin(m_children), it));
+            if (it == end(m_children) || j == i || removed[j]) {
+                continue;
+            }
+            removed[j] = true;
+            equivalent.emplace_back(other);
+            policy += it->get_policy();
+        }
+        if (equivalent.size() > 1) {
+            m_children[i]->set_policy(policy);
+            merged.emplace_back(std::move(equivalent));
+        }
+    }
+
+    auto kept = std::vector<UCTNodePointer>{};
+    kept.reserve(m_children.size());
+    for (size_t i = 0; i < m_children.size(); i++) {
+        if (!removed[i]) {
+            kept.emplace_back(std::move(m_children[i]));
+        }
+    }
+    m_children = std::move(kept);
+    return merged;
+}
+
+void UCTNode::unmerge_symmetric_children(
+    const std::vector<std::vector<int>>& merged) {
+
+    for (const auto& equivalent : merged) {
+        const auto it = std::find_if(begin(m_children), end(m_children),
+            [&](const UCTNodePointer& child) {
+                return child.get_move() == equivalent[0];
+            });
+        if (it == end(m_children)) {
+            continue;
+        }
+        // m_children grows below, keep the node itself.
+        const auto kept = it->get();
+        const auto count = int(equivalent.size());
+        const auto policy = kept->get_policy() / count;
+        const auto visits = kept->get_visits() / count;
+        const auto blackevals = visits > 0
+            ? kept->get_blackevals() * visits / kept->get_visits() : 0.0;
+        kept->set_policy(policy);
+        for (auto i = 1; i < count; i++) {
+            m_children.emplace_back(equivalent[i], policy);
+            m_children.back().inflate();
+            auto& copy = *m_children.back();
+            copy.m_visits = visits;
+            copy.m_blackevals = blackevals;
+            copy.m_net_eval = kept->m_net_eval;
+            copy.set_active(kept->active());
+        }
+        kept->m_visits -= visits * (count - 1);
+        kept->m_blackevals = kept->get_blackevals()
+                             - blackevals * (count - 1);
+    }
+}
+
 void UCTNode::prepare_root_node(Network & network, int color,
                                 std::atomic<int>& nodes,
                                 GameState& root_state) {
     float root_eval;
     const auto had_children = has_children();
     if (expandable()) {
-        printf("this node can expand \n");
+        Utils::myprintf("this node can expand \n");
         create_children(network, nodes, root_state, root_eval, 0.0f);
     }else{
-        printf("this node can not expand \n");
+        Utils::myprintf("this node can not expand \n");
     }
+    // A root expanded on the fast network gets its real priors before
+    // the noise is applied, or its first simulation would replace them.
+    auto correction = 0.0f;
+    reevaluate(network, root_state, correction);
     if (had_children) {
         root_eval = get_net_eval(color);
     } else {
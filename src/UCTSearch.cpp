@@ -34,6 +34,7 @@
 #include "FullBoard.h"
 #include "GTP.h"
 #include "GameState.h"
+#include "PerfCounters.h"
 #include "TimeControl.h"
 #include "Timing.h"
 #include "Training.h"
@@ -85,37 +86,121 @@ UCTSearch::UCTSearch(GameState& g, Network& network)
     : m_rootstate(g), m_network(network){
     set_playout_limit(cfg_max_playouts);
     set_visit_limit(cfg_max_visits);
+    m_strength.c_param = cfg_strength_c;
+    if (cfg_virtual_loss > 0) {
+        m_virtual_loss = cfg_virtual_loss;
+    }
+    if (cfg_prefetch > 0) {
+        // A few nodes' worth of requests, older ones are stale.
+        m_prefetcher = std::make_unique<Prefetcher>(
+            network, 4 * cfg_prefetch);
+    }
 
     m_root = std::make_unique<UCTNode>(FastBoard::PASS, 0.0f);
 }
 
-bool UCTSearch::advance_to_new_rootstate() {
-    if (!m_root || !m_last_rootstate) {
-        // No current state
-        return false;
-    }
+void UCTSearch::delete_tree(std::unique_ptr<UCTNode> root) {
+    // Lazy tree destruction.  Instead of calling the destructor of the
+    // old root node on the main thread, send the old root to a separate
+    // thread and destroy it from the child thread.  This will save a
+    // bit of time when dealing with large trees.
+    ThreadGroup tg(thread_pool);
+    auto p = root.release();
+    tg.add_task([p]() { delete p; });
+    m_delete_futures.push_back(std::move(tg));
+}
 
-    if (m_rootstate.get_komi() != m_last_rootstate->get_komi()) {
-        return false;
+void UCTSearch::cache_tree(std::uint64_t hash, float komi,
+                           std::unique_ptr<UCTNode> root) {
+    if (!root->has_children()) {
+        return;
     }
+    // Replace an older tree of the same position.
+    for (auto it = begin(m_tree_cache); it != end(m_tree_cache); ++it) {
+        if (it->hash == hash && it->komi == komi) {
+            delete_tree(std::move(it->root));
+            m_tree_cache.erase(it);
+            break;
+        }
+    }
+    // Without the cache the tree only passes through on its way to
+    // the new root, no need to walk it.
+    auto bytes = size_t{0};
+    if (cfg_tree_cache) {
+        const auto nodes = root->count_nodes_and_clear_expand_state();
+        bytes = nodes * (sizeof(UCTNode) + sizeof(UCTNodePointer));
+    }
+    m_tree_cache.push_front(CachedTree{hash, komi, std::move(root), bytes});
+}
 
-    auto depth =
-        int(m_rootstate.get_movenum() - m_last_rootstate->get_movenum());
-
-    if (depth < 0) {
+bool UCTSearch::attach_to_cached_parent(const GameState& state,
+                                        std::unique_ptr<UCTNode>& root) {
+    // Going back to the parent, put the subtree taken from it
+    // back in, so it is searched with all it knew.
+    auto parent_state = std::make_unique<GameState>(state);
+    if (!parent_state->undo_move()) {
         return false;
     }
+    const auto hash = parent_state->board.get_hash();
+    const auto komi = parent_state->get_komi();
+    for (auto it = begin(m_tree_cache); it != end(m_tree_cache); ++it) {
+        if (it->hash != hash || it->komi != komi) {
+            continue;
+        }
+        const auto nodes = root->count_nodes_and_clear_expand_state();
+        if (!it->root->attach_child(root)) {
+            return false;
+        }
+        it->bytes += nodes * (sizeof(UCTNode) + sizeof(UCTNodePointer));
+        m_tree_cache.splice(begin(m_tree_cache), m_tree_cache, it);
+        return true;
+    }
+    return false;
+}
 
+void UCTSearch::trim_tree_cache() {
+    const auto max_bytes = cfg_max_tree_size / TREE_CACHE_FRACTION;
+    const auto max_entries = cfg_tree_cache ? TREE_CACHE_ENTRIES : 0;
+    auto bytes = size_t{0};
+    auto entries = 0;
+    auto it = begin(m_tree_cache);
+    while (it != end(m_tree_cache)) {
+        bytes += it->bytes;
+        if (++entries > max_entries || bytes > max_bytes) {
+            delete_tree(std::move(it->root));
+            it = m_tree_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
 
+std::unique_ptr<UCTNode> UCTSearch::reuse_cached_tree() {
+    if (m_tree_cache.empty()) {
+        return nullptr;
+    }
+    // Find the cached tree of the closest position in the history
+    // of the new root.
     auto test = std::make_unique<GameState>(m_rootstate);
-    for (auto i = 0; i < depth; i++) {
-        test->undo_move();
+    auto cached = end(m_tree_cache);
+    auto depth = 0;
+    while (true) {
+        const auto hash = test->board.get_hash();
+        cached = std::find_if(begin(m_tree_cache), end(m_tree_cache),
+            [&](const CachedTree& tree) {
+                return tree.hash == hash
+                    && tree.komi == m_rootstate.get_komi();
+            });
+        if (cached != end(m_tree_cache) || !test->undo_move()) {
+            break;
+        }
+        depth++;
     }
-
-    if (m_last_rootstate->board.get_hash() != test->board.get_hash()) {
-        // m_rootstate and m_last_rootstate don't match
-        return false;
+    if (cached == end(m_tree_cache)) {
+        return nullptr;
     }
+    auto root = std::move(cached->root);
+    m_tree_cache.erase(cached);
 
     // Make sure that the nodes we destroyed the previous move are
     // in fact destroyed.
@@ -124,53 +209,52 @@ bool UCTSearch::advance_to_new_rootstate() {
         m_delete_futures.pop_front();
     }
 
-    // Try to replay moves advancing m_root
+    // Replay the moves down to the new root. The positions passed
+    // on the way are cached without the subtree that is taken.
     for (auto i = 0; i < depth; i++) {
-        ThreadGroup tg(thread_pool);
-
+        const auto hash = test->board.get_hash();
+        const auto to_move = test->get_to_move();
         test->forward_move();
-        const auto move = test->get_last_move();
-
-        auto oldroot = std::move(m_root);
-        m_root = oldroot->find_child(move);
-
-        // Lazy tree destruction.  Instead of calling the destructor of the
-        // old root node on the main thread, send the old root to a separate
-        // thread and destroy it from the child thread.  This will save a
-        // bit of time when dealing with large trees.
-        auto p = oldroot.release();
-        tg.add_task([p]() { delete p; });
-        m_delete_futures.push_back(std::move(tg));
-
-        if (!m_root) {
+        if (test->get_to_move() == to_move) {
+            // Can happen if user plays multiple moves in a row by same player
+            cache_tree(hash, m_rootstate.get_komi(), std::move(root));
+            return nullptr;
+        }
+        auto child = root->find_child(test->get_last_move());
+        cache_tree(hash, m_rootstate.get_komi(), std::move(root));
+        if (!child) {
             // Tree hasn't been expanded this far
-            return false;
+            return nullptr;
         }
-        m_last_rootstate->play_move(move);
+        root = std::move(child);
     }
-
-    assert(m_rootstate.get_movenum() == m_last_rootstate->get_movenum());
-
-    if (m_last_rootstate->board.get_hash() != test->board.get_hash()) {
-        // Can happen if user plays multiple moves in a row by same player
-        return false;
-    }
-
-    return true;
+    assert(test->board.get_hash() == m_rootstate.board.get_hash());
+    return root;
 }
 
 void UCTSearch::update_root() {
     // Definition of m_playouts is playouts per search call.
     // So reset this count now.
     m_playouts = 0;
+    m_collisions = 0;
+    m_expand_waits = 0;
+    m_window_collisions = 0;
 
 #ifndef NDEBUG
     auto start_nodes = m_root->count_nodes_and_clear_expand_state();
 #endif
 
-    if (!advance_to_new_rootstate() || !m_root) {
+    if (m_root && m_last_rootstate
+        && !(cfg_tree_cache
+             && attach_to_cached_parent(*m_last_rootstate, m_root))) {
+        cache_tree(m_last_rootstate->board.get_hash(),
+                   m_last_rootstate->get_komi(), std::move(m_root));
+    }
+    m_root = reuse_cached_tree();
+    if (!m_root) {
         m_root = std::make_unique<UCTNode>(FastBoard::PASS, 0.0f);
     }
+    trim_tree_cache();
     // Clear last_rootstate to prevent accidental use.
     m_last_rootstate.reset(nullptr);
 
@@ -204,11 +288,15 @@ float UCTSearch::get_min_psa_ratio() const {
 }
 
 SearchResult UCTSearch::play_simulation(GameState & currstate,
-                                        UCTNode* const node) {
+                                        UCTNode* const node,
+                                        bool on_pv) {
     const auto color = currstate.get_to_move();
     auto result = SearchResult{};
+    auto correction = 0.0f;
 
-    node->virtual_loss();
+    // Undo the same amount even if it gets re-tuned meanwhile.
+    const auto virtual_loss = m_virtual_loss.load();
+    node->virtual_loss(virtual_loss);
 
     if (node->expandable()) {
         if (currstate.get_passes() >= 2) {
@@ -217,31 +305,78 @@ SearchResult UCTSearch::play_simulation(GameState & currstate,
         } else {
             float eval;
             const auto had_children = node->has_children();
+            const auto fast = m_fast_network && node != m_root.get();
             const auto success =
-                node->create_children(m_network, m_nodes, currstate, eval,
+                node->create_children(fast ? *m_fast_network : m_network,
+                                      m_nodes, currstate, eval,
                                       get_min_psa_ratio());
             if (!had_children && success) {
+                if (fast) {
+                    node->set_fast_eval();
+                }
                 result = SearchResult::from_eval(eval);
+                if (m_prefetcher) {
+                    m_prefetcher->prefetch_children(currstate, *node,
+                                                    cfg_prefetch);
+                }
+            } else if (!success && !node->has_children()) {
+                // Another thread got here first, this playout is lost.
+                m_collisions++;
+                m_window_collisions++;
             }
         }
     }
 
     if (node->has_children() && !result.valid()) {
-        auto next = node->uct_select_child(color, node == m_root.get());
+        if (node->expanding()) {
+            m_expand_waits++;
+        }
+        UCTNode* next;
+        {
+            PerfCounters::Scope scope(PerfCounters::DESCENT);
+            next = node->uct_select_child(color, node == m_root.get());
+        }
         auto move = next->get_move();
 
-        currstate.play_move(move);
-        if (move != FastBoard::PASS && currstate.superko()) {
+        auto next_on_pv = false;
+        if (m_fast_network) {
+            if (node->fast_eval()
+                && (on_pv || node->get_visits() >= cfg_fast_eval_visits)) {
+                node->reevaluate(m_network, currstate, correction);
+            }
+            next_on_pv = on_pv;
+            node->for_each_child([&](const UCTNodePointer& child) {
+                if (child.get_visits() > next->get_visits()) {
+                    next_on_pv = false;
+                }
+            });
+        }
+
+        auto superko = false;
+        {
+            PerfCounters::Scope scope(PerfCounters::BOARD_UPDATE);
+            currstate.play_move(move);
+            superko = move != FastBoard::PASS && currstate.superko();
+        }
+        if (superko) {
             next->invalidate();
         } else {
-            result = play_simulation(currstate, next);
+            result = play_simulation(currstate, next, next_on_pv);
         }
     }
 
-    if (result.valid()) {
-        node->update(result.eval());
+    {
+        PerfCounters::Scope scope(PerfCounters::BACKUP);
+        if (result.valid()) {
+            node->update(result.eval());
+        }
+        // Fix up the evals this node got from re-evaluated descendants.
+        if (result.correction() != 0.0f) {
+            node->accumulate_eval(result.correction());
+        }
+        node->virtual_loss_undo(virtual_loss);
     }
-    node->virtual_loss_undo();
+    result.add_correction(correction);
 
     return result;
 }
@@ -331,17 +466,20 @@ void tree_stats_helper(UCTNode& node, size_t depth,
     depth_sum += depth;
     if (depth > max_depth) max_depth = depth;
 
-    for (auto& child : node.get_children()) {
+    auto leaves = node.get_num_children();
+    node.for_each_child([&](UCTNodePointer& child) {
         if (child.get_visits() > 0) {
+            leaves -= 1;
             children_count += 1;
             tree_stats_helper(*(child.get()), depth+1,
                               nodes, non_leaf_nodes, depth_sum,
                               max_depth, children_count);
-        } else {
-            nodes += 1;
-            depth_sum += depth+1;
-            if (depth+1 > max_depth) max_depth = depth+1;
         }
+    });
+    if (leaves > 0) {
+        nodes += leaves;
+        depth_sum += leaves * (depth+1);
+        if (depth+1 > max_depth) max_depth = depth+1;
     }
 }
 
@@ -443,7 +581,7 @@ int UCTSearch::get_best_move(passflag_t passflag) {
 
     // Make sure best is first
     m_root->sort_children(color);
-    m_root->usingStrengthControl(color,get_last_move());
+    m_root->usingStrengthControl(color,get_last_move(),m_strength);
     m_root->print_candidates(color,selectedWinrate);
 
     // Check whether to randomize the best move proportional
@@ -618,6 +756,13 @@ void UCTSearch::dump_analysis(int playouts) {
              playouts, winrate, pvstring.c_str());
 }
 
+float UCTSearch::get_root_eval(int color) const {
+    if (!m_root->get_visits()) {
+        return 0.5f;
+    }
+    return m_root->get_raw_eval(color);
+}
+
 bool UCTSearch::is_running() const {
     return m_run && UCTNodePointer::get_tree_size() < cfg_max_tree_size;
 }
@@ -704,6 +849,61 @@ bool UCTSearch::have_alternate_moves(int elapsed_centis, int time_for_move) {
     return false;
 }
 
+// Time for this move, scaled by how critical the root position looks.
+// A flat root policy, a close race between the two most visited moves
+// and a root eval that keeps swinging all ask for more time; a trivial
+// position gets as little as half the base time.
+int UCTSearch::complexity_time(int base_time, int max_extension) {
+    if (cfg_timemanage == TimeManagement::OFF || max_extension <= 0
+        || m_root->get_visits() < 100) {
+        return base_time;
+    }
+
+    const auto eval = m_root->get_raw_eval(FastBoard::BLACK);
+    if (m_snapshot_eval >= 0.0f) {
+        m_eval_volatility = std::max(m_eval_volatility,
+                                     std::fabs(eval - m_snapshot_eval));
+    }
+    m_snapshot_eval = eval;
+
+    auto entropy = 0.0f;
+    auto moves = 0;
+    auto first_visits = 0;
+    auto second_visits = 0;
+    for (const auto& child : m_root->get_children()) {
+        if (!child.valid()) {
+            continue;
+        }
+        const auto policy = child.get_policy();
+        if (policy > 0.0f) {
+            entropy -= policy * std::log(policy);
+        }
+        moves++;
+        const auto visits = child.get_visits();
+        if (visits > first_visits) {
+            second_visits = first_visits;
+            first_visits = visits;
+        } else if (visits > second_visits) {
+            second_visits = visits;
+        }
+    }
+    if (moves < 2 || first_visits == 0) {
+        return base_time;
+    }
+
+    const auto policy_spread = entropy / std::log(static_cast<float>(moves));
+    const auto visit_closeness = static_cast<float>(second_visits)
+                                 / first_visits;
+    const auto volatility = std::min(1.0f, m_eval_volatility / 0.05f);
+    const auto complexity =
+        (policy_spread + visit_closeness + volatility) / 3.0f;
+
+    // Base time at complexity 1/3, from 0.5x up to 2x.
+    const auto scale = 0.5f + 1.5f * complexity;
+    return std::min(base_time + max_extension,
+                    static_cast<int>(base_time * scale));
+}
+
 bool UCTSearch::stop_thinking(int elapsed_centis, int time_for_move) const {
     return
     m_playouts >= m_maxplayouts
@@ -722,7 +922,42 @@ void UCTWorker::operator()() {
 }
 
 void UCTSearch::increment_playouts() {
-    m_playouts++;
+    if (++m_playouts % VIRTUAL_LOSS_WINDOW == 0) {
+        adapt_virtual_loss();
+    }
+}
+
+// Raise the virtual loss when threads keep running into each other on
+// the same leaves, and lower it again when they rarely do, so it does
+// not push the threads further from the best line than needed. More
+// threads make some collisions unavoidable, so they are allowed more.
+void UCTSearch::adapt_virtual_loss() {
+    const auto collisions = m_window_collisions.exchange(0);
+    if (cfg_virtual_loss > 0 || m_search_threads < 2) {
+        return;
+    }
+    const auto rate =
+        static_cast<float>(collisions) / (VIRTUAL_LOSS_WINDOW + collisions);
+    const auto target = 0.002f * m_search_threads;
+    auto virtual_loss = m_virtual_loss.load();
+    if (rate > 2.0f * target && virtual_loss < MAX_VIRTUAL_LOSS) {
+        virtual_loss++;
+    } else if (rate < 0.5f * target && virtual_loss > 1) {
+        virtual_loss--;
+    }
+    m_virtual_loss = virtual_loss;
+}
+
+void UCTSearch::dump_collision_stats() const {
+    if (m_search_threads < 2) {
+        return;
+    }
+    const auto playouts = m_playouts.load();
+    const auto collisions = m_collisions.load();
+    myprintf("%d collisions (%.1f%%), %d expansion waits, virtual loss %d\n",
+             collisions,
+             100.0 * collisions / std::max(1, playouts + collisions),
+             m_expand_waits.load(), m_virtual_loss.load());
 }
 
 int UCTSearch::think(int color, passflag_t passflag) {
@@ -740,18 +975,39 @@ int UCTSearch::think(int color, passflag_t passflag) {
             m_rootstate.get_timecontrol().max_time_for_move(
                     m_rootstate.board.get_boardsize(),
                     color, m_rootstate.get_movenum());
+    const auto base_time = time_for_move;
+    const auto max_extension =
+            m_rootstate.get_timecontrol().max_time_extension(
+                    m_rootstate.board.get_boardsize(),
+                    color, m_rootstate.get_movenum());
+    m_snapshot_eval = -1.0f;
+    m_eval_volatility = 0.0f;
 
     myprintf("Thinking at most %.1f seconds...\n", time_for_move / 100.0f);
 
-    m_root->get_static_policy(m_network, m_rootstate);
+    m_root->get_static_policy(
+        m_policy_network ? *m_policy_network : m_network, m_rootstate);
 
     // create a sorted list of legal moves (make sure we
     // play something legal and decent even in time trouble)
+    const auto fresh_root = !m_root->has_children();
     m_root->prepare_root_node(m_network, color, m_nodes, m_rootstate);
+    if (fresh_root) {
+        m_symmetric_moves = m_root->merge_symmetric_children(m_rootstate);
+    }
 
 
     m_run = true;
+    if (m_prefetcher) {
+        m_prefetcher->start();
+    }
+    if (cfg_analyze_json && cfg_analyze_interval_centis) {
+        m_analysis_emitter.start(m_rootstate, *m_root,
+                                 cfg_analyze_interval_centis,
+                                 cfg_analyze_cpu_pct);
+    }
     int cpus = cfg_num_threads;
+    m_search_threads = cpus;
     ThreadGroup tg(thread_pool);
     for (int i = 1; i < cpus; i++) {
         tg.add_task(UCTWorker(m_rootstate, this, m_root.get()));
@@ -760,6 +1016,8 @@ int UCTSearch::think(int color, passflag_t passflag) {
     auto keeprunning = true;
     auto last_update = 0;
     auto last_output = 0;
+    auto last_snapshot = 0;
+    auto extended = false;
     do {
         auto currstate = std::make_unique<GameState>(m_rootstate);
 
@@ -771,7 +1029,7 @@ int UCTSearch::think(int color, passflag_t passflag) {
         Time elapsed;
         int elapsed_centis = Time::timediff_centis(start, elapsed);
 
-        if (cfg_analyze_interval_centis &&
+        if (!cfg_analyze_json && cfg_analyze_interval_centis &&
             elapsed_centis - last_output > cfg_analyze_interval_centis) {
             last_output = elapsed_centis;
             output_analysis(m_rootstate, *m_root);
@@ -783,6 +1041,15 @@ int UCTSearch::think(int color, passflag_t passflag) {
             last_update = elapsed_centis;
             dump_analysis(static_cast<int>(m_playouts));
         }
+        if (elapsed_centis - last_snapshot >= 50) {
+            last_snapshot = elapsed_centis;
+            time_for_move = complexity_time(base_time, max_extension);
+            if (time_for_move > base_time && !extended) {
+                extended = true;
+                myprintf("Critical position, thinking up to %.1f seconds.\n",
+                         (base_time + max_extension) / 100.0f);
+            }
+        }
         keeprunning = is_running();
         keeprunning &= !stop_thinking(elapsed_centis, time_for_move);
         keeprunning &= have_alternate_moves(elapsed_centis, time_for_move);
@@ -790,12 +1057,18 @@ int UCTSearch::think(int color, passflag_t passflag) {
 
     // stop the search
     m_run = false;
+    m_analysis_emitter.stop();
     tg.wait_all();
+    if (m_prefetcher) {
+        m_prefetcher->stop();
+    }
 
     // reactivate all pruned root children
     for (const auto &node : m_root->get_children()) {
         node->set_active(true);
     }
+    m_root->unmerge_symmetric_children(m_symmetric_moves);
+    m_symmetric_moves.clear();
 
     m_rootstate.stop_clock(color);
     if (!m_root->has_children()) {
@@ -805,7 +1078,9 @@ int UCTSearch::think(int color, passflag_t passflag) {
     // display search info
     myprintf("\n");
     dump_stats(m_rootstate, *m_root);
-    Training::record(m_network, m_rootstate, *m_root);
+    if (m_record_training) {
+        Training::record(m_network, m_rootstate, *m_root);
+    }
 
     Time elapsed;
     int elapsed_centis = Time::timediff_centis(start, elapsed);
@@ -816,6 +1091,7 @@ int UCTSearch::think(int color, passflag_t passflag) {
                  static_cast<int>(m_playouts),
                  (m_playouts * 100.0) / (elapsed_centis + 1));
     }
+    dump_collision_stats();
     int bestmove = get_best_move(passflag);
 
     // Copy the root state. Use to check for tree re-use in future calls.
@@ -839,18 +1115,39 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
             m_rootstate.get_timecontrol().max_time_for_move(
                     m_rootstate.board.get_boardsize(),
                     color, m_rootstate.get_movenum());
+    const auto base_time = time_for_move;
+    const auto max_extension =
+            m_rootstate.get_timecontrol().max_time_extension(
+                    m_rootstate.board.get_boardsize(),
+                    color, m_rootstate.get_movenum());
+    m_snapshot_eval = -1.0f;
+    m_eval_volatility = 0.0f;
 
     myprintf("Thinking at most %.1f seconds...\n", time_for_move / 100.0f);
 
-    m_root->get_static_policy(m_network, m_rootstate);
+    m_root->get_static_policy(
+        m_policy_network ? *m_policy_network : m_network, m_rootstate);
 
     // create a sorted list of legal moves (make sure we
     // play something legal and decent even in time trouble)
+    const auto fresh_root = !m_root->has_children();
     m_root->prepare_root_node(m_network, color, m_nodes, m_rootstate);
+    if (fresh_root) {
+        m_symmetric_moves = m_root->merge_symmetric_children(m_rootstate);
+    }
 
 
     m_run = true;
+    if (m_prefetcher) {
+        m_prefetcher->start();
+    }
+    if (cfg_analyze_json && cfg_analyze_interval_centis) {
+        m_analysis_emitter.start(m_rootstate, *m_root,
+                                 cfg_analyze_interval_centis,
+                                 cfg_analyze_cpu_pct);
+    }
     int cpus = cfg_num_threads;
+    m_search_threads = cpus;
     ThreadGroup tg(thread_pool);
     for (int i = 1; i < cpus; i++) {
         tg.add_task(UCTWorker(m_rootstate, this, m_root.get()));
@@ -859,6 +1156,8 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
     auto keeprunning = true;
     auto last_update = 0;
     auto last_output = 0;
+    auto last_snapshot = 0;
+    auto extended = false;
     do {
         auto currstate = std::make_unique<GameState>(m_rootstate);
 
@@ -870,7 +1169,7 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
         Time elapsed;
         int elapsed_centis = Time::timediff_centis(start, elapsed);
 
-        if (cfg_analyze_interval_centis &&
+        if (!cfg_analyze_json && cfg_analyze_interval_centis &&
             elapsed_centis - last_output > cfg_analyze_interval_centis) {
             last_output = elapsed_centis;
             output_analysis(m_rootstate, *m_root);
@@ -882,6 +1181,15 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
             last_update = elapsed_centis;
             dump_analysis(static_cast<int>(m_playouts));
         }
+        if (elapsed_centis - last_snapshot >= 50) {
+            last_snapshot = elapsed_centis;
+            time_for_move = complexity_time(base_time, max_extension);
+            if (time_for_move > base_time && !extended) {
+                extended = true;
+                myprintf("Critical position, thinking up to %.1f seconds.\n",
+                         (base_time + max_extension) / 100.0f);
+            }
+        }
         keeprunning = is_running();
         keeprunning &= !stop_thinking(elapsed_centis, time_for_move);
         keeprunning &= have_alternate_moves(elapsed_centis, time_for_move);
@@ -889,12 +1197,18 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
 
     // stop the search
     m_run = false;
+    m_analysis_emitter.stop();
     tg.wait_all();
+    if (m_prefetcher) {
+        m_prefetcher->stop();
+    }
 
     // reactivate all pruned root children
     for (const auto &node : m_root->get_children()) {
         node->set_active(true);
     }
+    m_root->unmerge_symmetric_children(m_symmetric_moves);
+    m_symmetric_moves.clear();
 
     m_rootstate.stop_clock(color);
 //    if (!m_root->has_children()) {
@@ -904,7 +1218,9 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
     // display search info
     myprintf("\n");
     dump_stats(m_rootstate, *m_root);
-    Training::record(m_network, m_rootstate, *m_root);
+    if (m_record_training) {
+        Training::record(m_network, m_rootstate, *m_root);
+    }
 
     Time elapsed;
     int elapsed_centis = Time::timediff_centis(start, elapsed);
@@ -915,6 +1231,7 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
                  static_cast<int>(m_playouts),
                  (m_playouts * 100.0) / (elapsed_centis + 1));
     }
+    dump_collision_stats();
     //int bestmove = get_best_move(passflag);
 
 
@@ -924,15 +1241,28 @@ std::vector<UCTNodePointer>& UCTSearch::think_s(int color, passflag_t passflag)
     return get_children();
 }
 
-void UCTSearch::ponder() {
+void UCTSearch::ponder(int threads, bool output) {
     update_root();
 
+    const auto fresh_root = !m_root->has_children();
     m_root->prepare_root_node(m_network, m_rootstate.board.get_to_move(),
                               m_nodes, m_rootstate);
+    if (fresh_root) {
+        m_symmetric_moves = m_root->merge_symmetric_children(m_rootstate);
+    }
 
     m_run = true;
+    m_search_threads = threads;
+    if (m_prefetcher) {
+        m_prefetcher->start();
+    }
+    if (output && cfg_analyze_json && cfg_analyze_interval_centis) {
+        m_analysis_emitter.start(m_rootstate, *m_root,
+                                 cfg_analyze_interval_centis,
+                                 cfg_analyze_cpu_pct);
+    }
     ThreadGroup tg(thread_pool);
-    for (int i = 1; i < cfg_num_threads; i++) {
+    for (int i = 1; i < threads; i++) {
         tg.add_task(UCTWorker(m_rootstate, this, m_root.get()));
     }
     Time start;
@@ -944,7 +1274,7 @@ void UCTSearch::ponder() {
         if (result.valid()) {
             increment_playouts();
         }
-        if (cfg_analyze_interval_centis) {
+        if (output && !cfg_analyze_json && cfg_analyze_interval_centis) {
             Time elapsed;
             int elapsed_centis = Time::timediff_centis(start, elapsed);
             if (elapsed_centis - last_output > cfg_analyze_interval_centis) {
@@ -958,13 +1288,24 @@ void UCTSearch::ponder() {
 
     // stop the search
     m_run = false;
+    m_analysis_emitter.stop();
     tg.wait_all();
-
-    // display search info
-    myprintf("\n");
-    dump_stats(m_rootstate, *m_root);
-
-    myprintf("\n%d visits, %d nodes\n\n", m_root->get_visits(), m_nodes.load());
+    if (m_prefetcher) {
+        m_prefetcher->stop();
+    }
+    m_root->unmerge_symmetric_children(m_symmetric_moves);
+    m_symmetric_moves.clear();
+
+    if (output) {
+        // display search info
+        myprintf("\n");
+        dump_stats(m_rootstate, *m_root);
+
+        myprintf("\n%d visits, %d nodes\n",
+                 m_root->get_visits(), m_nodes.load());
+        dump_collision_stats();
+        myprintf("\n");
+    }
 
     // Copy the root state. Use to check for tree re-use in future calls.
     m_last_rootstate = std::make_unique<GameState>(m_rootstate);
@@ -985,3 +1326,24 @@ void UCTSearch::set_visit_limit(int visits) {
     m_maxvisits = std::min(visits, UNLIMITED_PLAYOUTS);
 }
 
+void UCTSearch::set_strength(const StrengthParams& params) {
+    m_strength = params;
+}
+
+void UCTSearch::set_record_training(bool record) {
+    m_record_training = record;
+}
+
+void UCTSearch::set_policy_network(Network* network) {
+    m_policy_network = network;
+}
+
+void UCTSearch::set_fast_network(Network* network) {
+    m_fast_network = network;
+    if (m_fast_network && m_prefetcher) {
+        // New nodes are evaluated on the fast network now.
+        m_prefetcher = std::make_unique<Prefetcher>(
+            *m_fast_network, 4 * cfg_prefetch);
+    }
+}
+
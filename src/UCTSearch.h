@@ -32,7 +32,9 @@
 #include "FastState.h"
 #include "GameState.h"
 #include "UCTNode.h"
+#include "AnalysisEmitter.h"
 #include "Network.h"
+#include "Prefetcher.h"
 #include "UCTNodePointer.h"
 
 class SearchResult {
@@ -40,6 +42,10 @@ public:
     SearchResult() = default;
     bool valid() const { return m_valid;  }
     float eval() const { return m_eval;  }
+    // Change of the evals below the node this result comes from,
+    // after they were re-evaluated with the main network.
+    float correction() const { return m_correction; }
+    void add_correction(float correction) { m_correction += correction; }
     static SearchResult from_eval(float eval) {
         return SearchResult(eval);
     }
@@ -57,6 +63,7 @@ private:
         : m_valid(true), m_eval(eval) {}
     bool m_valid{false};
     float m_eval{0.0f};
+    float m_correction{0.0f};
 };
 
 namespace TimeManagement {
@@ -97,6 +104,23 @@ public:
     static constexpr auto UNLIMITED_PLAYOUTS =
         std::numeric_limits<int>::max() / 2;
 
+    /*
+        The virtual loss is re-tuned every VIRTUAL_LOSS_WINDOW playouts
+        and kept between 1 and MAX_VIRTUAL_LOSS.
+    */
+    static constexpr auto VIRTUAL_LOSS_WINDOW = 256;
+    static constexpr auto MAX_VIRTUAL_LOSS = 12;
+
+    /*
+        With cfg_tree_cache, trees of earlier roots are kept for
+        navigating back and forth (undo, loadsgf, variations). At most
+        TREE_CACHE_ENTRIES of them, using at most 1 / TREE_CACHE_FRACTION
+        of the tree memory. Otherwise only the subtree of the new root
+        is kept, as in normal play.
+    */
+    static constexpr auto TREE_CACHE_ENTRIES = 16;
+    static constexpr auto TREE_CACHE_FRACTION = 4;
+
     UCTSearch(GameState& g, Network & network);
 
     std::vector<UCTNodePointer>& think_s(int color, passflag_t passflag = NORMAL);
@@ -104,12 +128,30 @@ public:
 
     void set_playout_limit(int playouts);
     void set_visit_limit(int visits);
-    void ponder();
+    void set_strength(const StrengthParams& params);
+    void set_record_training(bool record);
+    // Take the static policy for strength control from this network
+    // instead of the searched one.
+    void set_policy_network(Network* network);
+    // Evaluate new nodes with this cheaper network, and again with the
+    // searched one once they reach cfg_fast_eval_visits visits or are
+    // on the principal variation.
+    void set_fast_network(Network* network);
+    // Root winrate for color after the last search.
+    float get_root_eval(int color) const;
+    // Principal variation after parent, which is the node of state.
+    static std::string get_pv(FastState& state, UCTNode& parent);
+    // Root children after the last search, best first.
+    std::vector<UCTNodePointer>& get_children();
+    // Search until there is input, on `threads` threads. Without
+    // output, no analysis or statistics are printed.
+    void ponder(int threads, bool output = true);
     int get_last_move();
     std::string get_last_comments(int color);
     bool is_running() const;
     void increment_playouts();
-    SearchResult play_simulation(GameState& currstate, UCTNode* const node);
+    SearchResult play_simulation(GameState& currstate, UCTNode* const node,
+                                 bool on_pv = true);
 
 private:
 
@@ -117,7 +159,6 @@ private:
     float get_min_psa_ratio() const;
     void dump_stats(FastState& state, UCTNode& parent);
     void tree_stats(UCTNode& node);
-    std::string get_pv(FastState& state, UCTNode& parent);
     void dump_analysis(int playouts);
     bool should_resign(passflag_t passflag, float besteval);
     bool have_alternate_moves(int elapsed_centis, int time_for_move);
@@ -125,30 +166,66 @@ private:
     size_t prune_noncontenders(int elapsed_centis = 0, int time_for_move = 0,
                                bool prune = true);
     bool stop_thinking(int elapsed_centis = 0, int time_for_move = 0) const;
+    void adapt_virtual_loss();
+    void dump_collision_stats() const;
+    int complexity_time(int base_time, int max_extension);
 
     int get_best_move(passflag_t passflag);
 
-    std::vector<UCTNodePointer>& get_children();
-
     void update_root();
-    bool advance_to_new_rootstate();
+    std::unique_ptr<UCTNode> reuse_cached_tree();
+    void cache_tree(std::uint64_t hash, float komi,
+                    std::unique_ptr<UCTNode> root);
+    bool attach_to_cached_parent(const GameState& state,
+                                 std::unique_ptr<UCTNode>& root);
+    void trim_tree_cache();
+    void delete_tree(std::unique_ptr<UCTNode> root);
     void output_analysis(FastState & state, UCTNode & parent);
 
     GameState & m_rootstate;
     std::unique_ptr<GameState> m_last_rootstate;
     std::unique_ptr<UCTNode> m_root;
+    // Root moves merged by UCTNode::merge_symmetric_children for the
+    // current search.
+    std::vector<std::vector<int>> m_symmetric_moves;
     std::atomic<int> m_nodes{0};
     std::atomic<int> m_playouts{0};
+    // Playouts lost because another thread was expanding the same leaf,
+    // and selections that had to wait for another thread's expansion.
+    std::atomic<int> m_collisions{0};
+    std::atomic<int> m_expand_waits{0};
+    std::atomic<int> m_window_collisions{0};
+    std::atomic<int> m_virtual_loss{UCTNode::VIRTUAL_LOSS_COUNT};
+    int m_search_threads{1};
     std::atomic<bool> m_run{false};
     int m_maxplayouts;
     int m_maxvisits;
     float selectedWinrate;
+    StrengthParams m_strength;
+    bool m_record_training{true};
+    // Root eval at the last time-management snapshot, and the largest
+    // change between two snapshots during this search.
+    float m_snapshot_eval{-1.0f};
+    float m_eval_volatility{0.0f};
 
     std::string m_candidates;
 
     std::list<Utils::ThreadGroup> m_delete_futures;
 
+    struct CachedTree {
+        std::uint64_t hash;
+        float komi;
+        std::unique_ptr<UCTNode> root;
+        size_t bytes;
+    };
+    // Most recently used first.
+    std::list<CachedTree> m_tree_cache;
+
     Network & m_network;
+    Network * m_policy_network{nullptr};
+    Network * m_fast_network{nullptr};
+    std::unique_ptr<Prefetcher> m_prefetcher;
+    AnalysisEmitter m_analysis_emitter;
 };
 
 class UCTWorker {
@@ -0,0 +1,97 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Exercises the C interface of the engine library.
+    Usage: capi_test weights [weights_s]
+*/
+
+#include <stdio.h>
+
+#include "LeelaApi.h"
+
+#define MAX_CANDIDATES 16
+
+static int failures = 0;
+
+static void check(int condition, const char* what) {
+    if (!condition) {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s weights [weights_s]\n", argv[0]);
+        return 2;
+    }
+
+    check(lz_engine_create("no-such-file", NULL, 1) == NULL,
+          "missing weights are rejected");
+
+    lz_engine* engine = lz_engine_create(argv[1], argc > 2 ? argv[2] : NULL, 1);
+    if (!engine) {
+        printf("Could not create engine: %s\n", lz_engine_error(NULL));
+        return 1;
+    }
+
+    const int size = lz_board_size();
+    const int center = size / 2 + (size / 2) * size;
+    const int moves[] = { center, center + 1, LZ_PASS };
+
+    check(lz_set_position(engine, moves, 3, 7.5f) == 0, "set position");
+
+    int best = LZ_RESIGN;
+    check(lz_search(engine, 0, 0, 0, &best) == -1, "search needs a limit");
+    check(lz_search(engine, 50, 0, 0, &best) == 0, "search");
+    check(best == LZ_PASS || best == LZ_RESIGN
+          || (best >= 0 && best < size * size), "best move on the board");
+    check(best != center && best != center + 1, "best move is empty");
+
+    lz_candidate candidates[MAX_CANDIDATES];
+    const int count = lz_get_candidates(engine, candidates, MAX_CANDIDATES);
+    check(count > 0, "candidates");
+    for (int i = 0; i < count; i++) {
+        const lz_candidate* c = &candidates[i];
+        printf("%3d %4d %.3f %.3f %.3f\n", c->move, c->visits,
+               c->winrate, c->prior, c->static_policy);
+        check(c->visits > 0, "candidate visited");
+        check(c->winrate >= 0.0f && c->winrate <= 1.0f, "winrate range");
+        check(c->prior >= 0.0f && c->prior <= 1.0f, "prior range");
+        check(c->static_policy >= 0.0f && c->static_policy <= 1.0f,
+              "static policy range");
+        check(i == 0 || c->visits <= candidates[i - 1].visits,
+              "best candidates first");
+    }
+
+    const int occupied[] = { center, center };
+    check(lz_set_position(engine, occupied, 2, 7.5f) == -1,
+          "illegal move is rejected");
+    check(lz_get_candidates(engine, candidates, MAX_CANDIDATES) == -1,
+          "no candidates without a search");
+
+    lz_engine_destroy(engine);
+
+    if (failures) {
+        printf("%d check(s) failed.\n", failures);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/filesystem.hpp>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+#include "FastBoard.h"
+#include "GameArchive.h"
+
+namespace fs = boost::filesystem;
+
+static GameRecord make_record(int game) {
+    auto record = GameRecord{};
+    record.board_size = BOARD_SIZE;
+    record.komi = 7.5f;
+    record.date = "2018-06-01";
+    record.time_control = "0 1 0";
+    record.black = "black " + std::to_string(game);
+    record.white = "white " + std::to_string(game);
+    record.result = "B+Resign";
+    record.options = "-v 1600";
+    record.handicap = {};
+    for (auto i = 0; i < 10 + game; i++) {
+        const auto color = (i % 2 == 0) ? FastBoard::BLACK : FastBoard::WHITE;
+        record.moves.push_back({color, i * 7 % NUM_INTERSECTIONS,
+                                "move " + std::to_string(i)});
+    }
+    record.moves.push_back({FastBoard::BLACK, GameRecord::PASS, ""});
+    return record;
+}
+
+static void expect_equal(const GameRecord& a, const GameRecord& b) {
+    EXPECT_EQ(a.board_size, b.board_size);
+    EXPECT_EQ(a.komi, b.komi);
+    EXPECT_EQ(a.date, b.date);
+    EXPECT_EQ(a.time_control, b.time_control);
+    EXPECT_EQ(a.black, b.black);
+    EXPECT_EQ(a.white, b.white);
+    EXPECT_EQ(a.result, b.result);
+    EXPECT_EQ(a.options, b.options);
+    EXPECT_EQ(a.handicap, b.handicap);
+    ASSERT_EQ(a.moves.size(), b.moves.size());
+    for (size_t i = 0; i < a.moves.size(); i++) {
+        EXPECT_EQ(a.moves[i].color, b.moves[i].color);
+        EXPECT_EQ(a.moves[i].move, b.moves[i].move);
+        EXPECT_EQ(a.moves[i].comment, b.moves[i].comment);
+    }
+}
+
+class GameArchiveTest : public ::testing::Test {
+public:
+    GameArchiveTest()
+        : m_filename((fs::temp_directory_path() / fs::unique_path()).string()
+                     + ".lza") {}
+    ~GameArchiveTest() {
+        fs::remove(m_filename);
+        fs::remove(m_filename + ".idx");
+    }
+
+protected:
+    std::string m_filename;
+};
+
+TEST_F(GameArchiveTest, AppendAndGet) {
+    GameArchive archive(m_filename);
+    EXPECT_EQ(archive.size(), (size_t)0);
+    for (auto game = 0; game < 3; game++) {
+        archive.append(make_record(game));
+    }
+    ASSERT_EQ(archive.size(), (size_t)3);
+    for (auto game = 0; game < 3; game++) {
+        expect_equal(archive.get(game), make_record(game));
+    }
+
+    // A new instance reads the index.
+    GameArchive reopened(m_filename);
+    ASSERT_EQ(reopened.size(), (size_t)3);
+    expect_equal(reopened.get(1), make_record(1));
+}
+
+TEST_F(GameArchiveTest, OutOfRange) {
+    GameArchive archive(m_filename);
+    EXPECT_THROW(archive.get(0), std::out_of_range);
+    archive.append(make_record(0));
+    EXPECT_NO_THROW(archive.get(0));
+    EXPECT_THROW(archive.get(1), std::out_of_range);
+}
+
+TEST_F(GameArchiveTest, RebuildsIndex) {
+    {
+        GameArchive archive(m_filename);
+        archive.append(make_record(0));
+        archive.append(make_record(1));
+    }
+    fs::remove(m_filename + ".idx");
+
+    GameArchive archive(m_filename);
+    ASSERT_EQ(archive.size(), (size_t)2);
+    expect_equal(archive.get(1), make_record(1));
+}
+
+TEST_F(GameArchiveTest, TwoWriters) {
+    GameArchive first(m_filename);
+    GameArchive second(m_filename);
+    first.append(make_record(0));
+    second.append(make_record(1));
+    first.append(make_record(2));
+
+    GameArchive archive(m_filename);
+    ASSERT_EQ(archive.size(), (size_t)3);
+    for (auto game = 0; game < 3; game++) {
+        expect_equal(archive.get(game), make_record(game));
+    }
+}
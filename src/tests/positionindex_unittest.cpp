@@ -0,0 +1,114 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "ChunkShuffler.h"
+#include "Network.h"
+#include "PositionIndex.h"
+#include "Random.h"
+#include "Zobrist.h"
+
+namespace fs = boost::filesystem;
+
+// A position without symmetries of its own, and a policy that sums
+// exactly in floating point.
+static ChunkSample make_sample() {
+    auto sample = ChunkSample{};
+    for (const auto v : {0, 1, 20}) {
+        sample.planes[0][v] = true;
+    }
+    for (const auto v : {50, 100}) {
+        sample.planes[Network::INPUT_MOVES][v] = true;
+    }
+    sample.probabilities.fill(0.0f);
+    sample.probabilities[1] = 0.5f;
+    sample.probabilities[40] = 0.25f;
+    sample.probabilities[POTENTIAL_MOVES - 1] = 0.25f;
+    sample.to_move = 0;
+    sample.winner = 1.0f;
+    return sample;
+}
+
+static std::uint64_t canonical_key(const ChunkSample& sample) {
+    auto key = sample.get_symmetry_hash(0);
+    for (auto s = 1; s < Network::NUM_SYMMETRIES; s++) {
+        key = std::min(key, sample.get_symmetry_hash(s));
+    }
+    return key;
+}
+
+class PositionIndexTest : public ::testing::Test {
+public:
+    PositionIndexTest()
+        : m_directory(fs::temp_directory_path() / fs::unique_path()) {
+        // The same tables as leelaz.
+        auto rng = Random{5489};
+        Zobrist::init_zobrist(rng);
+    }
+    ~PositionIndexTest() {
+        fs::remove_all(m_directory);
+    }
+
+protected:
+    fs::path m_directory;
+};
+
+TEST_F(PositionIndexTest, SymmetriesShareKey) {
+    const auto sample = make_sample();
+    const auto key = canonical_key(sample);
+    for (auto s = 1; s < Network::NUM_SYMMETRIES; s++) {
+        EXPECT_EQ(canonical_key(sample.apply_symmetry(s)), key);
+    }
+}
+
+TEST_F(PositionIndexTest, SymmetriesMerge) {
+    const auto sample = make_sample();
+    {
+        PositionIndex index(m_directory.string(), 4);
+        for (auto s = 0; s < Network::NUM_SYMMETRIES; s++) {
+            index.add(sample.apply_symmetry(s));
+        }
+        index.merge();
+        EXPECT_EQ(index.get_positions(), (size_t)Network::NUM_SYMMETRIES);
+        EXPECT_EQ(index.get_unique_positions(), (size_t)1);
+    }
+
+    // The merged sample is stored in the canonical symmetry.
+    auto canonical = sample;
+    for (auto s = 0; s < Network::NUM_SYMMETRIES; s++) {
+        const auto rotated = sample.apply_symmetry(s);
+        if (rotated.get_symmetry_hash(0) == canonical_key(sample)) {
+            canonical = rotated;
+        }
+    }
+
+    PositionIndex index(m_directory.string(), 4);
+    auto merged = std::vector<ChunkSample>{};
+    index.for_each([&](const ChunkSample& s) { merged.emplace_back(s); });
+    ASSERT_EQ(merged.size(), (size_t)1);
+    EXPECT_EQ(merged[0].weight, float(Network::NUM_SYMMETRIES));
+    EXPECT_EQ(merged[0].winner, 1.0f);
+    EXPECT_EQ(merged[0].to_move, 0);
+    EXPECT_EQ(merged[0].planes, canonical.planes);
+    EXPECT_EQ(merged[0].probabilities, canonical.probabilities);
+}
@@ -0,0 +1,116 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "SPRT.h"
+
+static void add_games(Sprt& sprt, Sprt::GameResult result, int count) {
+    for (auto i = 0; i < count; i++) {
+        sprt.add_game_result(result);
+    }
+}
+
+// Adds count pairs worth half_points (0 to 4) to the first player.
+static void add_pairs(Sprt& sprt, int half_points, int count) {
+    static const std::array<std::array<Sprt::GameResult, 2>, 5> pairs = {{
+        {{Sprt::Loss, Sprt::Loss}},
+        {{Sprt::Draw, Sprt::Loss}},
+        {{Sprt::Win, Sprt::Loss}},
+        {{Sprt::Win, Sprt::Draw}},
+        {{Sprt::Win, Sprt::Win}}
+    }};
+    for (auto i = 0; i < count; i++) {
+        sprt.add_pair_result(pairs[half_points][0], pairs[half_points][1]);
+    }
+}
+
+TEST(SprtTest, EloEstimate) {
+    Sprt even;
+    add_games(even, Sprt::Win, 50);
+    add_games(even, Sprt::Loss, 50);
+    EXPECT_NEAR(even.get_elo().diff, 0.0, 1e-9);
+
+    // A 60% score is 70.4 Elo.
+    Sprt sixty;
+    add_games(sixty, Sprt::Win, 60);
+    add_games(sixty, Sprt::Loss, 40);
+    EXPECT_NEAR(sixty.get_elo().diff, 70.4365, 1e-3);
+    EXPECT_NEAR(sixty.get_elo().error, 70.5712, 1e-3);
+
+    Sprt draws;
+    add_games(draws, Sprt::Win, 30);
+    add_games(draws, Sprt::Loss, 20);
+    add_games(draws, Sprt::Draw, 50);
+    EXPECT_NEAR(draws.get_elo().diff, 34.8601, 1e-3);
+    EXPECT_NEAR(draws.get_elo().error, 48.4702, 1e-3);
+}
+
+TEST(SprtTest, PentanomialLLR) {
+    Sprt sprt;
+    sprt.initialize(0.0, 35.0, 0.05, 0.05);
+    const auto counts = std::array<int, 5>{{2, 10, 20, 12, 6}};
+    for (auto i = 0; i < 5; i++) {
+        add_pairs(sprt, i, counts[i]);
+    }
+    EXPECT_EQ(sprt.get_pentanomial(), counts);
+
+    const auto status = sprt.status();
+    EXPECT_EQ(status.result, Sprt::Continue);
+    EXPECT_NEAR(status.llr, 0.961523, 1e-5);
+    EXPECT_NEAR(status.lBound, std::log(0.05 / 0.95), 1e-9);
+    EXPECT_NEAR(status.uBound, std::log(0.95 / 0.05), 1e-9);
+}
+
+TEST(SprtTest, PentanomialDecides) {
+    Sprt better;
+    better.initialize(0.0, 35.0, 0.05, 0.05);
+    add_pairs(better, 4, 60);
+    add_pairs(better, 2, 40);
+    EXPECT_EQ(better.status().result, Sprt::AcceptH1);
+
+    Sprt worse;
+    worse.initialize(0.0, 35.0, 0.05, 0.05);
+    add_pairs(worse, 0, 60);
+    add_pairs(worse, 2, 40);
+    EXPECT_EQ(worse.status().result, Sprt::AcceptH0);
+}
+
+TEST(SprtTest, SaveAndLoad) {
+    Sprt sprt;
+    sprt.initialize(0.0, 35.0, 0.05, 0.05);
+    add_pairs(sprt, 1, 3);
+    add_pairs(sprt, 3, 5);
+    std::stringstream stream;
+    stream << sprt;
+
+    Sprt loaded;
+    stream >> loaded;
+    EXPECT_EQ(loaded.get_wdl(), sprt.get_wdl());
+    EXPECT_EQ(loaded.get_pentanomial(), sprt.get_pentanomial());
+    EXPECT_EQ(loaded.status().llr, sprt.status().llr);
+
+    // Files from before the pair counts.
+    std::istringstream old("0 35 0.05 0.05 10 5 1\n");
+    old >> loaded;
+    EXPECT_EQ(loaded.get_wdl(), std::make_tuple(10, 1, 5));
+    EXPECT_EQ(loaded.get_pentanomial(), (std::array<int, 5>{}));
+}
@@ -0,0 +1,89 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "FastBoard.h"
+#include "Network.h"
+#include "UCTChildList.h"
+
+// Children sorted best first, with a pass last. Most of the priors
+// (1/3, 1/5, ...) are not exact in fp16.
+static std::vector<Network::PolicyVertexPair> make_nodelist(size_t size) {
+    auto nodelist = std::vector<Network::PolicyVertexPair>{};
+    for (size_t i = 0; i + 1 < size; i++) {
+        nodelist.emplace_back(1.0f / (3.0f + i),
+                              FastBoard::NUM_VERTICES - 1 - int(i));
+    }
+    nodelist.emplace_back(1.0f / (3.0f + size), FastBoard::PASS);
+    return nodelist;
+}
+
+TEST(UCTChildListTest, PriorsRoundTrip) {
+    const auto nodelist = make_nodelist(40);
+    const auto list = UCTChildList::create(nodelist);
+
+    ASSERT_EQ(list->size(), nodelist.size());
+    for (size_t i = 0; i < nodelist.size(); i++) {
+        EXPECT_EQ(list->get_move(i), nodelist[i].second);
+        EXPECT_EQ(list->get_policy(i), nodelist[i].first);
+    }
+}
+
+TEST(UCTChildListTest, SlotsArePrefix) {
+    const auto nodelist = make_nodelist(40);
+    const auto list = UCTChildList::create(nodelist);
+    EXPECT_EQ(list->slots(), (size_t)0);
+
+    // Slots are added a whole chunk at a time.
+    list->materialize(1);
+    EXPECT_EQ(list->slots(), UCTChildList::FIRST_CHUNK);
+    list->materialize(UCTChildList::FIRST_CHUNK);
+    EXPECT_EQ(list->slots(), UCTChildList::FIRST_CHUNK);
+    list->materialize(UCTChildList::FIRST_CHUNK + 1);
+    EXPECT_EQ(list->slots(), 3 * UCTChildList::FIRST_CHUNK);
+    list->materialize(1000);
+    EXPECT_EQ(list->slots(), nodelist.size());
+
+    for (size_t i = 0; i < list->slots(); i++) {
+        EXPECT_EQ(list->slot(i).get_move(), list->get_move(i));
+        EXPECT_EQ(list->slot(i).get_policy(), list->get_policy(i));
+    }
+
+    auto moves = std::vector<int>{};
+    list->for_each_slot(list->slots(), [&](const UCTNodePointer& child) {
+        moves.emplace_back(child.get_move());
+    });
+    ASSERT_EQ(moves.size(), nodelist.size());
+    for (size_t i = 0; i < moves.size(); i++) {
+        EXPECT_EQ(moves[i], nodelist[i].second);
+    }
+}
+
+TEST(UCTChildListTest, MinPsaRatio) {
+    const auto list = UCTChildList::create(make_nodelist(40));
+    EXPECT_EQ(list->visible(), (size_t)0);
+
+    // The priors are 1/3, 1/4, 1/5, 1/6, 1/7...
+    list->set_min_psa_ratio(0.5f);
+    EXPECT_EQ(list->visible(), (size_t)4);
+    list->set_min_psa_ratio(0.0f);
+    EXPECT_EQ(list->visible(), list->size());
+}
@@ -0,0 +1,200 @@
+/*
+    This file is part of Leela Zero.
+    Copyright (C) 2017-2018 Gian-Carlo Pascutto and contributors
+
+    Leela Zero is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Leela Zero is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Reads training chunks written by leelaz and writes them out as
+    shuffled, symmetry augmented tensor shards, see ChunkShuffler.h.
+    With --dedup the chunks are first added to a PositionIndex and
+    the shards hold each distinct position once.
+*/
+
+#include "config.h"
+
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ChunkShuffler.h"
+#include "PositionIndex.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include "Timing.h"
+#include "Utils.h"
+#include "Zobrist.h"
+
+using namespace Utils;
+
+int main(int argc, char *argv[]) {
+    namespace po = boost::program_options;
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help,h", "Show commandline options.")
+        ("output,o", po::value<std::string>(),
+                     "Prefix of the shard files to write. "
+                     "Can be left out with --dedup to only update the index.")
+        ("shuffle-size", po::value<size_t>()->default_value(250000),
+                         "Number of samples in the shuffle reservoir.")
+        ("shard-size", po::value<size_t>()->default_value(16384),
+                       "Number of samples per shard.")
+        ("random-symmetry", "Write each position once in a random symmetry "
+                            "instead of in all 8.")
+        ("threads,t", po::value<int>(),
+                      "Number of chunk decoding threads. "
+                      "Default: number of cores.")
+        ("seed,s", po::value<std::uint64_t>(),
+                   "Random number generation seed.")
+        ("dedup", po::value<std::string>(),
+                  "Merge repeated positions through the position index "
+                  "in this directory.")
+        ("dedup-partitions", po::value<int>()->default_value(256),
+                             "Number of partitions of a new position index. "
+                             "One partition must fit in memory.")
+        ;
+    po::options_description h_desc("Hidden options");
+    h_desc.add_options()
+        ("chunks", po::value<std::vector<std::string>>());
+    po::options_description all;
+    all.add(desc).add(h_desc);
+    po::positional_options_description p_desc;
+    p_desc.add("chunks", -1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv)
+                  .options(all).positional(p_desc).run(), vm);
+        po::notify(vm);
+    } catch(const boost::program_options::error& e) {
+        printf("ERROR: %s\n", e.what());
+        std::cout << desc << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (vm.count("help") || !vm.count("chunks")
+        || (!vm.count("output") && !vm.count("dedup"))) {
+        std::cout << "Usage: chunkshuffle [options] -o prefix chunk..."
+                  << std::endl << desc << std::endl;
+        return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    auto threads = int(std::max(std::thread::hardware_concurrency(), 1u));
+    if (vm.count("threads")) {
+        threads = std::max(vm["threads"].as<int>(), 1);
+    }
+    thread_pool.initialize(threads);
+
+    // The position index keys depend on these staying the same.
+    auto rng = std::make_unique<Random>(5489);
+    Zobrist::init_zobrist(*rng);
+    if (vm.count("seed")) {
+        Random::get_Rng().seedrandom(vm["seed"].as<std::uint64_t>());
+    }
+
+    auto chunks = vm["chunks"].as<std::vector<std::string>>();
+    std::shuffle(begin(chunks), end(chunks), Random::get_Rng());
+
+    const auto all_symmetries = !vm.count("random-symmetry");
+    const auto output = vm.count("output") ? vm["output"].as<std::string>()
+                                           : std::string{};
+    auto shuffler = ChunkShuffler{output,
+                                  vm["shuffle-size"].as<size_t>(),
+                                  vm["shard-size"].as<size_t>()};
+    auto index = std::unique_ptr<PositionIndex>{};
+
+    Time start;
+    try {
+        if (vm.count("dedup")) {
+            index = std::make_unique<PositionIndex>(
+                vm["dedup"].as<std::string>(),
+                vm["dedup-partitions"].as<int>());
+        }
+        // Decode a few chunks per thread at a time, the shuffling
+        // itself is cheap.
+        const auto batch_size = size_t(4 * threads);
+        for (auto first = size_t{0}; first < chunks.size();
+             first += batch_size) {
+            const auto last = std::min(first + batch_size, chunks.size());
+            auto samples = std::vector<std::vector<ChunkSample>>(last - first);
+            ThreadGroup tg(thread_pool);
+            for (auto i = first; i < last; i++) {
+                tg.add_task([&samples, &chunks, &index, first, i,
+                             all_symmetries]() {
+                    try {
+                        auto chunk_samples =
+                            ChunkShuffler::load_chunk(chunks[i]);
+                        // Deduplicated samples are augmented on the
+                        // way out of the index.
+                        samples[i - first] = index
+                            ? std::move(chunk_samples)
+                            : ChunkShuffler::augment(chunk_samples,
+                                                     all_symmetries);
+                    } catch (const std::exception& e) {
+                        myprintf("%s, skipping it\n", e.what());
+                    }
+                });
+            }
+            tg.wait_all();
+            for (const auto& chunk_samples : samples) {
+                if (index) {
+                    for (const auto& sample : chunk_samples) {
+                        index->add(sample);
+                    }
+                } else {
+                    shuffler.add(chunk_samples);
+                }
+            }
+        }
+
+        if (index) {
+            index->merge();
+            myprintf("Position index holds %zu positions, %zu distinct.\n",
+                     index->get_positions(), index->get_unique_positions());
+            if (!output.empty()) {
+                index->for_each([&shuffler, all_symmetries](
+                                    const ChunkSample& sample) {
+                    shuffler.add(ChunkShuffler::augment({sample},
+                                                        all_symmetries));
+                });
+            }
+        }
+        if (!output.empty()) {
+            shuffler.finish();
+        }
+    } catch (const std::exception& e) {
+        myprintf("%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    if (output.empty()) {
+        return EXIT_SUCCESS;
+    }
+    Time elapsed;
+    const auto elapsed_s = std::max(Time::timediff_seconds(start, elapsed),
+                                    0.01);
+    myprintf("Wrote %zu samples in %zu shards in %.2f seconds "
+             "(%.0f samples/s).\n",
+             shuffler.get_samples_written(), shuffler.get_shards_written(),
+             elapsed_s, shuffler.get_samples_written() / elapsed_s);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+#
+#    This file is part of Leela Zero.
+#    Copyright (C) 2017-2018 Gian-Carlo Pascutto
+#
+#    Leela Zero is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    Leela Zero is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with Leela Zero.  If not, see <http://www.gnu.org/licenses/>.
+
+import numpy as np
+import random
+
+# Matches ChunkShuffler::ShardHeader.
+HEADER = np.dtype([('magic', 'S4'), ('version', '<u4'),
+                   ('board_size', '<u4'), ('input_channels', '<u4'),
+                   ('count', '<u4')])
+
+def load_shard(filename):
+    """
+        Map a shard written by chunkshuffle into memory.
+
+        Returns (planes, probs, winner, weight) as arrays of shape
+        [count, channels, intersections] uint8, [count, intersections + 1]
+        float32, [count] float32 and [count] float32, without copying
+        the data. The weight is the number of occurrences of a position
+        in deduplicated shards and 1 otherwise.
+    """
+    header = np.fromfile(filename, dtype=HEADER, count=1)[0]
+    assert header['magic'] == b'LZSH', filename
+    assert header['version'] == 2, header['version']
+    count = int(header['count'])
+    intersections = int(header['board_size']) ** 2
+    channels = int(header['input_channels'])
+
+    offset = HEADER.itemsize
+    winner = np.memmap(filename, dtype='<f4', mode='r',
+                       offset=offset, shape=(count,))
+    offset += winner.nbytes
+    weight = np.memmap(filename, dtype='<f4', mode='r',
+                       offset=offset, shape=(count,))
+    offset += weight.nbytes
+    probs = np.memmap(filename, dtype='<f4', mode='r',
+                      offset=offset, shape=(count, intersections + 1))
+    offset += probs.nbytes
+    planes = np.memmap(filename, dtype=np.uint8, mode='r',
+                       offset=offset, shape=(count, channels, intersections))
+    return planes, probs, winner, weight
+
+class ShardParser:
+    def __init__(self, shards, batch_size=256, weights=False):
+        """
+            Yield batches of raw tensors from chunkshuffle shards, in
+            the same format as ChunkParser.parse(). The shards are
+            already shuffled and augmented, so this only slices them.
+            With 'weights' the sample weights are yielded as a fourth
+            element.
+        """
+        self.shards = list(shards)
+        self.batch_size = batch_size
+        self.weights = weights
+
+    def parse(self):
+        shards = self.shards[:]
+        random.shuffle(shards)
+        for shard in shards:
+            planes, probs, winner, weight = load_shard(shard)
+            for i in range(0, len(winner) - self.batch_size + 1,
+                           self.batch_size):
+                batch = slice(i, i + self.batch_size)
+                tensors = (planes[batch].tobytes(),
+                           probs[batch].tobytes(),
+                           winner[batch].tobytes())
+                if self.weights:
+                    tensors += (weight[batch].tobytes(),)
+                yield tensors
@@ -18,7 +18,7 @@
 
 #include "Results.h"
 #include "../autogtp/Game.h"
-#include "SPRT.h"
+#include "../src/SPRT.h"
 #include <QString>
 #include <iostream>
 
@@ -19,7 +19,7 @@
 #ifndef RESULTS_H
 #define RESULTS_H
 
-#include "SPRT.h"
+#include "../src/SPRT.h"
 #include <QString>
 
 
@@ -20,98 +20,196 @@
 #include <QFile>
 #include <QDir>
 #include <QUuid>
+#include <sstream>
 
 using VersionTuple = std::tuple<int, int, int>;
 // Minimal Leela Zero version we expect to see
 const VersionTuple min_leelaz_version{0, 16, 0};
+// Never adjudicate before half the 13x13 board is filled.
+constexpr int ADJUDICATE_MIN_MOVES = 13 * 13 / 2;
 
 
-void ValidationWorker::run() {
+bool ValidationWorker::prepareEngines() {
+    for (auto i = 0; i < 2; i++) {
+        auto& game = m_games[i];
+        if (game && game->isRunning()) {
+            if (game->gameReset()) {
+                m_startupSaved += game->getStartupTime();
+                continue;
+            }
+            QTextStream(stdout) << "Engine reset failed, restarting." << endl;
+            game->gameQuit();
+        }
+        game = std::make_unique<Game>(m_engines[i].m_network,
+                                      m_engines[i].m_options,
+                                      m_engines[i].m_binary,
+                                      m_engines[i].m_commands);
+        if (!game->gameStart(min_leelaz_version)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ValidationWorker::quitEngines() {
+    for (auto& game : m_games) {
+        if (game) {
+            game->gameQuit();
+            game.reset();
+        }
+    }
+}
+
+bool ValidationWorker::adjudicate(Game& mover, Game& referee) {
+    if (!m_adjudicator) {
+        return false;
+    }
+    // The winrate comes from the engine that just moved, so both
+    // engines have to agree over consecutive moves.
+    float winrate, score;
+    if (!mover.getWinrate(winrate) || !referee.getAreaScore(score)) {
+        return false;
+    }
+    if (m_adjudicator->add_move(winrate, score) == Adjudicator::NONE) {
+        return false;
+    }
+    referee.setAdjudicated();
+    QTextStream(stdout) << "Game adjudicated after "
+                        << referee.getMovesCount() << " moves." << endl;
+    return true;
+}
+
+bool ValidationWorker::playGame(QStringList& opening,
+                                Sprt::GameResult& result) {
+    if (!prepareEngines()) {
+        return false;
+    }
+    if (m_adjudicator) {
+        m_adjudicator->new_game();
+    }
+    auto& first = *m_games[0];
+    auto& second = *m_games[1];
+    QTextStream(stdout) << "starting:" << endl <<
+        first.getCmdLine() << endl <<
+        "vs" << endl <<
+        second.getCmdLine() << endl;
+
+    QString wmove = "play white ";
+    QString bmove = "play black ";
+    // The second game of a pair replays the opening of the first,
+    // the first game records it.
+    const auto replay = !opening.isEmpty();
+    for (auto i = 0; i < opening.size(); i++) {
+        auto play = ((i % 2) == 0 ? bmove : wmove) + opening[i];
+        if (!first.setMove(play) || !second.setMove(play)) {
+            return false;
+        }
+    }
+    auto record = [&](const Game& mover) {
+        if (!replay && opening.size() < m_openingMoves) {
+            opening << mover.getMove();
+        }
+    };
     do {
-        Game first(m_engines[0].m_network, m_engines[0].m_options,
-                   m_engines[0].m_binary, m_engines[0].m_commands);
-        if (!first.gameStart(min_leelaz_version)) {
-            emit resultReady(Sprt::NoResult, Game::BLACK);
-            return;
+        first.move();
+        if (!first.waitForMove()) {
+            return false;
         }
-        Game second(m_engines[1].m_network, m_engines[1].m_options,
-                    m_engines[1].m_binary, m_engines[1].m_commands);
-        if (!second.gameStart(min_leelaz_version)) {
-            emit resultReady(Sprt::NoResult, Game::BLACK);
-            return;
+        first.readMove();
+        adjudicate(first, first);
+        if (first.checkGameEnd()) {
+            break;
         }
-        QTextStream(stdout) << "starting:" << endl <<
-            first.getCmdLine() << endl <<
-            "vs" << endl <<
-            second.getCmdLine() << endl;
+        record(first);
+        second.setMove(bmove + first.getMove());
+        second.move();
+        if (!second.waitForMove()) {
+            return false;
+        }
+        second.readMove();
+        first.setMove(wmove + second.getMove());
+        adjudicate(second, first);
+        if (!first.checkGameEnd()) {
+            record(second);
+        }
+        second.nextMove();
+    } while (first.nextMove() && m_state.load() == RUNNING);
+    // Black moves first in both games.
+    if (opening.size() % 2) {
+        opening.removeLast();
+    }
 
-        QString wmove = "play white ";
-        QString bmove = "play black ";
-        do {
-            first.move();
-            if (!first.waitForMove()) {
-                emit resultReady(Sprt::NoResult, Game::BLACK);
-                return;
-            }
-            first.readMove();
-            if (first.checkGameEnd()) {
-                break;
-            }
-            second.setMove(bmove + first.getMove());
-            second.move();
-            if (!second.waitForMove()) {
-                emit resultReady(Sprt::NoResult, Game::BLACK);
-                return;
+    if (m_state.load() != RUNNING) {
+        result = Sprt::NotEnded;
+        return true;
+    }
+    QTextStream(stdout) << "Game has ended." << endl;
+    int winner = 0;
+    if (first.getScore()) {
+        winner = first.getWinner();
+        if (!m_keepPath.isEmpty()) {
+            first.writeSgf();
+            QString prefix = m_keepPath + '/';
+            if (m_expected == Game::BLACK) {
+                prefix.append("black_");
+            } else {
+                prefix.append("white_");
             }
-            second.readMove();
-            first.setMove(wmove + second.getMove());
-            second.nextMove();
-        } while (first.nextMove() && m_state.load() == RUNNING);
+            QFile(first.getFile() + ".sgf").rename(prefix + first.getFile() + ".sgf");
+        }
+    }
+    if (m_startupSaved > 0) {
+        QTextStream(stdout) << "Engines kept running, "
+            << m_startupSaved / 1000.0
+            << " s of startup saved so far." << endl;
+    }
+    result = (winner == m_expected) ? Sprt::Win : Sprt::Loss;
 
-        if (m_state.load() == RUNNING) {
-            QTextStream(stdout) << "Game has ended." << endl;
-            int result = 0;
-            if (first.getScore()) {
-                result = first.getWinner();
-                if (!m_keepPath.isEmpty()) {
-                    first.writeSgf();
-                    QString prefix = m_keepPath + '/';
-                    if (m_expected == Game::BLACK) {
-                        prefix.append("black_");
-                    } else {
-                        prefix.append("white_");
-                    }
-                    QFile(first.getFile() + ".sgf").rename(prefix + first.getFile() + ".sgf");
-                }
-            }
-            QTextStream(stdout) << "Stopping engine." << endl;
-            first.gameQuit();
-            second.gameQuit();
+    // Change color for the next game, the engines
+    // follow their networks.
+    std::swap(m_engines[0], m_engines[1]);
+    std::swap(m_games[0], m_games[1]);
+    if (m_expected == Game::BLACK) {
+        m_expected = Game::WHITE;
+    } else {
+        m_expected = Game::BLACK;
+    }
+    return true;
+}
 
-            // Game is finished, send the result
-            if (result == m_expected) {
-                emit resultReady(Sprt::Win, m_expected);
-            } else {
-                emit resultReady(Sprt::Loss, m_expected);
+void ValidationWorker::run() {
+    do {
+        // Both games of a pair start from the same opening,
+        // with the networks on swapped colors.
+        const auto netOneColor = m_expected;
+        QStringList opening;
+        std::array<Sprt::GameResult, 2> results{{Sprt::NotEnded,
+                                                 Sprt::NotEnded}};
+        for (auto& result : results) {
+            if (!playGame(opening, result)) {
+                quitEngines();
+                emit resultReady(Sprt::NoResult, Sprt::NoResult, netOneColor);
+                return;
             }
-            // Change color and play again
-            std::swap(m_engines[0], m_engines[1]);
-            if (m_expected == Game::BLACK) {
-                m_expected = Game::WHITE;
-            } else {
-                m_expected = Game::BLACK;
+            if (result == Sprt::NotEnded) {
+                break;
             }
-        } else {
-            first.gameQuit();
-            second.gameQuit();
+        }
+        // Unfinished pairs are dropped.
+        if (results[1] != Sprt::NotEnded) {
+            emit resultReady(results[0], results[1], netOneColor);
         }
     } while (m_state.load() != FINISHING);
+    QTextStream(stdout) << "Stopping engine." << endl;
+    quitEngines();
 }
 
 void ValidationWorker::init(const QString& gpuIndex,
                             const QVector<Engine>& engines,
                             const QString& keep,
-                            int expected) {
+                            int expected,
+                            const Adjudication& adjudication,
+                            int openingMoves) {
     m_engines = engines;
     if (!gpuIndex.isEmpty()) {
         m_engines[0].m_options.prepend(" --gpu=" + gpuIndex + " ");
@@ -119,6 +217,15 @@ void ValidationWorker::init(const QString& gpuIndex,
     }
     m_expected = expected;
     m_keepPath = keep;
+    m_startupSaved = 0;
+    // An even number, so black starts in both games of a pair.
+    m_openingMoves = openingMoves - (openingMoves % 2);
+    m_adjudicator.reset();
+    if (adjudication.m_winratePct > 0) {
+        m_adjudicator = std::make_unique<Adjudicator>(
+            adjudication.m_winratePct, adjudication.m_moves,
+            ADJUDICATE_MIN_MOVES, adjudication.m_playoutPct);
+    }
     m_state.store(RUNNING);
 }
 
@@ -129,7 +236,9 @@ Validation::Validation(const int gpus,
                        const QString& keep,
                        QMutex* mutex,
                        const float& h0,
-                       const float& h1) :
+                       const float& h1,
+                       const Adjudication& adjudication,
+                       const int openingMoves) :
 
     m_mainMutex(mutex),
     m_syncMutex(),
@@ -138,9 +247,11 @@ Validation::Validation(const int gpus,
     m_gpus(gpus),
     m_gpusList(gpuslist),
     m_engines(engines),
-    m_keepPath(keep) {
+    m_keepPath(keep),
+    m_adjudication(adjudication),
+    m_openingMoves(openingMoves) {
     m_statistic.initialize(h0, h1, 0.05, 0.05);
-    m_statistic.addGameResult(Sprt::Draw);
+    m_statistic.add_game_result(Sprt::Draw);
 }
 
 void Validation::startGames() {
@@ -166,7 +277,8 @@ void Validation::startGames() {
             }
 
             m_gamesThreads[thread_index].init(
-                myGpu, engines, m_keepPath, expected);
+                myGpu, engines, m_keepPath, expected, m_adjudication,
+                m_openingMoves);
             m_gamesThreads[thread_index].start();
         }
     }
@@ -178,7 +290,9 @@ void Validation::saveSprt() {
         return;
     }
     QTextStream out(&f);
-    out << m_statistic;
+    std::ostringstream sprt;
+    sprt << m_statistic;
+    out << QString::fromStdString(sprt.str());
     out << m_results;
     f.close();
     m_results.printResults(m_engines[0].m_network, m_engines[1].m_network);
@@ -200,7 +314,8 @@ void Validation::loadSprt() {
         return;
     }
     QTextStream in(&f);
-    in >> m_statistic;
+    std::istringstream sprt(in.readLine().toStdString());
+    sprt >> m_statistic;
     in >> m_results;
     f.close();
     QFile::remove(fi.fileName());
@@ -212,6 +327,12 @@ void Validation::loadSprt() {
 void Validation::printSprtStatus(const Sprt::Status& status) {
     QTextStream(stdout)
         << m_results.getGamesPlayed() << " games played." << endl;
+    auto pairs = m_statistic.get_pentanomial();
+    QTextStream(stdout) << "Pairs (0, 0.5, 1, 1.5, 2 points):";
+    for (auto count : pairs) {
+        QTextStream(stdout) << ' ' << count;
+    }
+    QTextStream(stdout) << endl;
     QTextStream(stdout)
         << "Status: " << status.result
         << " LLR " << status.llr
@@ -219,17 +340,20 @@ void Validation::printSprtStatus(const Sprt::Status& status) {
         << " Upper Bound " << status.uBound << endl;
 }
 
-void Validation::getResult(Sprt::GameResult result, int net_one_color) {
-    if (result == Sprt::NoResult) {
+void Validation::getResult(Sprt::GameResult first, Sprt::GameResult second,
+                           int net_one_color) {
+    if (first == Sprt::NoResult || second == Sprt::NoResult) {
         QTextStream(stdout) << "Engine Error." << endl;
         return;
     }
     m_syncMutex.lock();
-    m_statistic.addGameResult(result);
-    m_results.addGameResult(result, net_one_color);
+    m_statistic.add_pair_result(first, second);
+    m_results.addGameResult(first, net_one_color);
+    m_results.addGameResult(second, net_one_color == Game::BLACK
+                                    ? Game::WHITE : Game::BLACK);
 
     Sprt::Status status = m_statistic.status();
-    auto wdl = m_statistic.getWDL();
+    auto wdl = m_statistic.get_wdl();
     QTextStream(stdout) << std::get<0>(wdl) << " wins, "
                         << std::get<2>(wdl) << " losses" << endl;
     if (status.result != Sprt::Continue) {
@@ -24,8 +24,11 @@
 #include <QVector>
 #include <QAtomicInt>
 #include <QMutex>
-#include "SPRT.h"
+#include <array>
+#include <memory>
+#include "../src/SPRT.h"
 #include "../autogtp/Game.h"
+#include "../src/Adjudicator.h"
 #include "Results.h"
 
 class Engine {
@@ -43,6 +46,13 @@ public:
     QStringList m_commands;
 };
 
+class Adjudication {
+public:
+    int m_winratePct{0};    // 0 disables adjudication
+    int m_moves{10};
+    int m_playoutPct{10};
+};
+
 class ValidationWorker : public QThread {
     Q_OBJECT
 public:
@@ -57,17 +67,34 @@ public:
     void init(const QString& gpuIndex,
               const QVector<Engine>& engines,
               const QString& keep,
-              int expected);
+              int expected,
+              const Adjudication& adjudication,
+              int openingMoves);
     void run() override;
     void doFinish() { m_state.store(FINISHING); }
 
 signals:
-    void resultReady(Sprt::GameResult r, int net_one_color);
+    // Results of net one in a pair of games, and its color
+    // in the first of them.
+    void resultReady(Sprt::GameResult first, Sprt::GameResult second,
+                     int net_one_color);
 private:
+    // Engine processes, kept running between games.
+    // Index matches m_engines.
+    std::array<std::unique_ptr<Game>, 2> m_games;
     QVector<Engine> m_engines;
     int m_expected;
     QString m_keepPath;
     QAtomicInt m_state;
+    qint64 m_startupSaved{0};
+    int m_openingMoves{0};
+    std::unique_ptr<Adjudicator> m_adjudicator;
+    bool prepareEngines();
+    // Plays one game of a pair, see run(). Returns false if an
+    // engine failed.
+    bool playGame(QStringList& opening, Sprt::GameResult& result);
+    void quitEngines();
+    bool adjudicate(Game& mover, Game& referee);
 };
 
 class Validation : public QObject {
@@ -80,7 +107,9 @@ public:
                const QString& keep,
                QMutex* mutex,
                const float& h0,
-               const float& h1);
+               const float& h1,
+               const Adjudication& adjudication,
+               const int openingMoves);
     ~Validation() = default;
     void startGames();
     void wait();
@@ -88,7 +117,8 @@ public:
 signals:
     void sendQuit();
 public slots:
-    void getResult(Sprt::GameResult result, int net_one_color);
+    void getResult(Sprt::GameResult first, Sprt::GameResult second,
+                   int net_one_color);
     void storeSprt();
 private:
     QMutex* m_mainMutex;
@@ -101,6 +131,8 @@ private:
     QStringList m_gpusList;
     QVector<Engine>& m_engines;
     QString m_keepPath;
+    Adjudication m_adjudication;
+    int m_openingMoves;
     void quitThreads();
     void saveSprt();
     void printSprtStatus(const Sprt::Status& status);
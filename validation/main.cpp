@@ -73,6 +73,26 @@ int main(int argc, char *argv[]) {
             "Save SGF files after each self-play game.",
             "output directory");
 
+    QCommandLineOption adjudicateOption(
+        {"a", "adjudicate"},
+            "End a game when both engines and the area score agree a player "
+            "wins with 'pct' percent or more (default 0, disabled).",
+            "pct", "0");
+    QCommandLineOption adjudicateMovesOption(
+        "adjudicate-moves",
+            "Consecutive moves that must agree before adjudicating (default 10).",
+            "num", "10");
+    QCommandLineOption adjudicatePlayoutOption(
+        "adjudicate-playout",
+            "Percentage of games that are played out regardless (default 10).",
+            "pct", "10");
+
+    QCommandLineOption openingMovesOption(
+        "opening-moves",
+            "Games are played in pairs with colors swapped, the second game "
+            "replays the first 'num' moves of the first (default 8).",
+            "num", "8");
+
     parser.addOption(gamesNumOption);
     parser.addOption(gpusOption);
     parser.addOption(sprtOption);
@@ -80,6 +100,10 @@ int main(int argc, char *argv[]) {
     parser.addOption(networkOption);
     parser.addOption(optionsOption);
     parser.addOption(gtpCommandOption);
+    parser.addOption(adjudicateOption);
+    parser.addOption(adjudicateMovesOption);
+    parser.addOption(adjudicatePlayoutOption);
+    parser.addOption(openingMovesOption);
     parser.addPositionalArgument(
         "[-- binary [--gtp-command...] [-- binary [--gtp-command...]]]",
         "Binary to execute for the game (default ./leelaz).\n"
@@ -138,6 +162,16 @@ int main(int argc, char *argv[]) {
         engine_idx++;
     }
 
+    Adjudication adjudication;
+    adjudication.m_winratePct = parser.value(adjudicateOption).toInt();
+    adjudication.m_moves = parser.value(adjudicateMovesOption).toInt();
+    adjudication.m_playoutPct = parser.value(adjudicatePlayoutOption).toInt();
+    if (adjudication.m_winratePct != 0
+        && (adjudication.m_winratePct <= 50
+            || adjudication.m_winratePct > 100)) {
+        parser.showHelp();
+    }
+
     QMutex mutex;
     QTextStream(stdout) << "SPRT : " << sprtOpt << " h0 " << h0 << " h1 " << h1 << endl;
 
@@ -145,7 +179,8 @@ int main(int argc, char *argv[]) {
     Validation *validate = new Validation(gpusNum, gamesNum, gpusList,
                                           engines,
                                           parser.value(keepSgfOption), &mutex,
-                                          h0, h1);
+                                          h0, h1, adjudication,
+                                          parser.value(openingMovesOption).toInt());
     QObject::connect(&app, &QCoreApplication::aboutToQuit, validate, &Validation::storeSprt);
     validate->loadSprt();
     validate->startGames();
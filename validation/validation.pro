@@ -10,13 +10,15 @@ TEMPLATE = app
 
 SOURCES += main.cpp \
     ../autogtp/Game.cpp \
-    SPRT.cpp \
+    ../src/Adjudicator.cpp \
+    ../src/SPRT.cpp \
     Validation.cpp \
     Results.cpp
 
 HEADERS += \
     ../autogtp/Game.h \
-    SPRT.h \
+    ../src/Adjudicator.h \
+    ../src/SPRT.h \
     Validation.h \
     Results.h \
     ../autogtp/Console.h